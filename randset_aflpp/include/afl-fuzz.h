@@ -282,6 +282,13 @@ struct priority_queue {
   int coverage;
 };
 
+struct path_cache_entry {
+
+  u64 trace_hash;                       /* classify_counts_hash(), 0 = free */
+  u64 cksum;                            /* hash64() of the classified trace */
+
+};
+
 struct extra_data {
 
   u8 *data;                             /* Dictionary token data            */
@@ -481,7 +488,7 @@ typedef struct afl_env_vars {
       afl_keep_timeouts, afl_no_crash_readme, afl_ignore_timeouts,
       afl_no_startup_calibration, afl_no_warn_instability,
       afl_post_process_keep_original, afl_crashing_seeds_as_new_crash,
-      afl_final_sync, afl_ignore_seed_problems;
+      afl_final_sync, afl_ignore_seed_problems, afl_path_cache;
 
   u8 *afl_tmpdir, *afl_custom_mutator_library, *afl_python_module, *afl_path,
       *afl_hang_tmout, *afl_forksrv_init_tmout, *afl_preload,
@@ -635,6 +642,11 @@ typedef struct afl_state {
 #define N_FUZZ_SIZE (1 << 21)
   u32 *n_fuzz;
 
+  struct path_cache_entry *path_cache;  /* Recently seen, boring paths      */
+  u64 path_cache_hits,                  /* Execs answered by the cache      */
+      path_cache_collisions;            /* Hits disproved by validation     */
+  u32 path_cache_left;                  /* Hits until the next validation   */
+
   volatile u8 stop_soon,                /* Ctrl-C pressed?                  */
       clear_screen;                     /* Window resized?                  */
 
@@ -1274,6 +1286,7 @@ u8 has_new_bits(afl_state_t *, u8 *);
 u8 has_new_bits_unclassified(afl_state_t *, u8 *);
 #ifndef AFL_SHOWMAP
 void classify_counts(afl_forkserver_t *);
+u64  classify_counts_hash(afl_forkserver_t *);
 #endif
 
 /* Extras */
@@ -148,6 +148,30 @@ FILE *create_ffile(u8 *fn);
 /* create a file */
 s32 create_file(u8 *fn);
 
+/* A control flow graph in the AFL_CFG_PATH format - one "src dst" pair of
+   edge ids per line, the file afl-fuzz loads in load_cfg() - as compressed
+   successor lists: the successors of edge id i are succ[off[i]] up to
+   succ[off[i + 1] - 1]. */
+
+typedef struct afl_cfg {
+
+  u32  map_size;                       /* edge ids are below this           */
+  u32  edges;                          /* CFG edges loaded                  */
+  u32 *off;                            /* map_size + 1 offsets into succ    */
+  u32 *succ;                           /* successor edge ids                */
+
+} afl_cfg_t;
+
+/* Load the CFG at path, for edge ids below map_size. Like load_cfg(), keeps
+   at most MAX_SUCCESSORS successors per edge. */
+void afl_cfg_load(afl_cfg_t *cfg, u8 *path, u32 map_size);
+
+/* Same definition as is_frontier_node_outer() in afl-fuzz, with hit[] (non
+   zero = hit) standing in for the virgin map: edge id has more than one CFG
+   successor, and at least one of them is not hit. Whether id itself is hit
+   is up to the caller. */
+u8 afl_cfg_is_frontier(afl_cfg_t *cfg, u8 *hit, u32 id);
+
 /* memmem implementation as not all platforms support this */
 void *afl_memmem(const void *haystack, size_t haystacklen, const void *needle,
                  size_t needlelen);
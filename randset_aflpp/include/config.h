@@ -263,6 +263,11 @@
 #define TMIN_SET_MIN_SIZE 4
 #define TMIN_SET_STEPS 128
 
+/* Bytes zeroed per exec in the first try of afl-tmin -F character
+   minimization, rejected ranges are bisected: */
+
+#define TMIN_FRONTIER_BATCH 64
+
 /* Maximum dictionary token size (-x), in bytes: */
 
 #define MAX_DICT_FILE 128
@@ -477,6 +482,19 @@
 #define MAX_SUCCESSORS 1024     
 #define RECENT_FRONTIER_LIMIT 100  
 
+/* Path hash cache (AFL_PATH_CACHE): number of slots (2^PATH_CACHE_SIZE_POW2)
+   and slots probed per lookup. A cache hit is re-validated with the full
+   has_new_bits() scan about every PATH_CACHE_VALIDATE_MS worth of execs at
+   the current exec speed, but at least every PATH_CACHE_VALIDATE_MAX and at
+   most every PATH_CACHE_VALIDATE_MIN hits - so fast targets, which hit the
+   cap, validate on an even shorter cycle. */
+
+#define PATH_CACHE_SIZE_POW2 14
+#define PATH_CACHE_PROBES 4
+#define PATH_CACHE_VALIDATE_MS 50
+#define PATH_CACHE_VALIDATE_MIN 16
+#define PATH_CACHE_VALIDATE_MAX 1024
+
 #define ROUND_DOWN_BITMAP(a, b) ((a) / (b))
 #define ROUND_UP_BITMAP(a, b) ROUND_DOWN_BITMAP(((a) + (b) - 1), b)
 
@@ -72,6 +72,35 @@ inline void classify_counts(afl_forkserver_t *fsrv) {
 
 }
 
+/* classify_counts() that also folds every non-zero classified word and its
+   position into a 64-bit path hash in the same pass. Cheaper than hash64()
+   over the whole map for sparse traces; used only to key the path cache.
+   Never returns 0. */
+
+inline u64 classify_counts_hash(afl_forkserver_t *fsrv) {
+
+  u64 *mem = (u64 *)fsrv->trace_bits;
+  u32  i = (fsrv->map_size >> 3);
+  u64  h = HASH_CONST;
+
+  while (i--) {
+
+    if (unlikely(*mem)) {
+
+      *mem = classify_word(*mem);
+      h ^= ((u64)*mem ^ ((u64)i << 32)) * 0x9e3779b97f4a7c15ULL;
+      h = (h << 27) | (h >> 37);
+
+    }
+
+    mem++;
+
+  }
+
+  return h ? h : 1;
+
+}
+
 /* Updates the virgin bits, then reflects whether a new count or a new tuple is
  * seen in ret. */
 inline void discover_word(u8 *ret, u64 *current, u64 *virgin) {
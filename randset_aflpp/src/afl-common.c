@@ -1411,6 +1411,95 @@ s32 create_file(u8 *fn) {
 
 }
 
+/* Load a CFG file into compressed successor lists */
+
+void afl_cfg_load(afl_cfg_t *cfg, u8 *path, u32 map_size) {
+
+  FILE *f = fopen(path, "r");
+  u32   src, dst, i, n = 0, size = 0, dropped = 0, *pairs = NULL, *fill;
+
+  if (!f) { PFATAL("Unable to open CFG '%s'", path); }
+
+  cfg->map_size = map_size;
+  cfg->off = ck_alloc((map_size + 1) * sizeof(u32));
+
+  while (fscanf(f, "%u %u", &src, &dst) == 2) {
+
+    if (src >= map_size || dst >= map_size) { continue; }
+
+    if (cfg->off[src + 1] == MAX_SUCCESSORS) {
+
+      ++dropped;
+      continue;
+
+    }
+
+    if (n == size) {
+
+      size = size ? size << 1 : 4096;
+      pairs = realloc(pairs, size * 2 * sizeof(u32));
+      if (!pairs) { PFATAL("realloc() failed"); }
+
+    }
+
+    pairs[2 * n] = src;
+    pairs[2 * n + 1] = dst;
+    ++cfg->off[src + 1];
+    ++n;
+
+  }
+
+  fclose(f);
+
+  for (i = 0; i < map_size; i++) {
+
+    cfg->off[i + 1] += cfg->off[i];
+
+  }
+
+  cfg->succ = ck_alloc((n + 1) * sizeof(u32));
+  fill = ck_alloc(map_size * sizeof(u32));
+
+  for (i = 0; i < n; i++) {
+
+    src = pairs[2 * i];
+    cfg->succ[cfg->off[src] + fill[src]++] = pairs[2 * i + 1];
+
+  }
+
+  ck_free(fill);
+  free(pairs);
+  cfg->edges = n;
+
+  if (dropped) {
+
+    WARNF("Dropped %u CFG edges beyond %u successors per edge.", dropped,
+          MAX_SUCCESSORS);
+
+  }
+
+  if (!be_quiet) { OKF("Loaded %u CFG edges from '%s'.", n, path); }
+
+}
+
+/* Is the edge a frontier edge of the hit map? */
+
+u8 afl_cfg_is_frontier(afl_cfg_t *cfg, u8 *hit, u32 id) {
+
+  u32 i;
+
+  if (cfg->off[id + 1] - cfg->off[id] <= 1) { return 0; }
+
+  for (i = cfg->off[id]; i < cfg->off[id + 1]; i++) {
+
+    if (!hit[cfg->succ[i]]) { return 1; }
+
+  }
+
+  return 0;
+
+}
+
 #ifdef __linux__
 
 /* Nyx requires a tmp workdir to access specific files (such as mmapped files,
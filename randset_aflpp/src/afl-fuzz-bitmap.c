@@ -448,6 +448,75 @@ void write_crash_readme(afl_state_t *afl) {
 
 }
 
+/* Path hash cache. Keys are classify_counts_hash() values of traces that
+   were checked and brought nothing new; since virgin bits only ever shrink,
+   such a path can never become interesting again. Lookups probe a fixed
+   number of slots and never stop at holes, so an entry can be dropped by
+   simply zeroing its key. */
+
+/* Cache hits until the next validation: PATH_CACHE_VALIDATE_MS worth of
+   execs at the current exec speed, clamped to the PATH_CACHE_VALIDATE_*
+   bounds. */
+
+static inline u32 path_cache_interval(afl_state_t *afl) {
+
+  double n = afl->stats_avg_exec * PATH_CACHE_VALIDATE_MS / 1000;
+
+  if (n < PATH_CACHE_VALIDATE_MIN) { return PATH_CACHE_VALIDATE_MIN; }
+  if (n > PATH_CACHE_VALIDATE_MAX) { return PATH_CACHE_VALIDATE_MAX; }
+  return (u32)n;
+
+}
+
+static inline struct path_cache_entry *path_cache_lookup(afl_state_t *afl,
+                                                         u64 trace_hash) {
+
+  u32 mask = (1U << PATH_CACHE_SIZE_POW2) - 1;
+  u32 i;
+
+  for (i = 0; i < PATH_CACHE_PROBES; ++i) {
+
+    struct path_cache_entry *e = &afl->path_cache[(trace_hash + i) & mask];
+    if (e->trace_hash == trace_hash) { return e; }
+
+  }
+
+  return NULL;
+
+}
+
+static inline void path_cache_insert(afl_state_t *afl, u64 trace_hash,
+                                     u64 cksum) {
+
+  u32                      mask = (1U << PATH_CACHE_SIZE_POW2) - 1;
+  struct path_cache_entry *e = NULL;
+  u32                      i;
+
+  for (i = 0; i < PATH_CACHE_PROBES; ++i) {
+
+    struct path_cache_entry *slot = &afl->path_cache[(trace_hash + i) & mask];
+    if (slot->trace_hash == trace_hash || !slot->trace_hash) {
+
+      e = slot;
+      break;
+
+    }
+
+  }
+
+  /* All probed slots taken: evict one, picked by the upper hash bits. */
+  if (!e) {
+
+    e = &afl->path_cache[(trace_hash + (trace_hash >> 60) % PATH_CACHE_PROBES) &
+                         mask];
+
+  }
+
+  e->trace_hash = trace_hash;
+  e->cksum = cksum;
+
+}
+
 /* Check if the result of an execve() during routine fuzzing is interesting,
    save or queue the input test case for further analysis if so. Returns 1 if
    entry is saved, 0 otherwise. */
@@ -479,7 +548,44 @@ save_if_interesting(afl_state_t *afl, void *mem, u32 len, u8 fault) {
   u8  new_bits = 0, keeping = 0, res, classified = 0, is_timeout = 0,
      need_hash = 1;
   s32 fd;
-  u64 cksum = 0;
+  u64 cksum = 0, trace_hash = 0;
+
+  struct path_cache_entry *cached = NULL;
+
+  /* With AFL_PATH_CACHE (FAST..RARE schedules only), hash the trace while
+     classifying it. A path we already know to be boring needs neither
+     has_new_bits() nor hash64(), except when a validation is due, which
+     takes the full route below to catch hash collisions. */
+
+  if (unlikely(afl->path_cache) && likely(fault == afl->crash_mode)) {
+
+    trace_hash = classify_counts_hash(&afl->fsrv);
+    classified = 1;
+
+    cached = path_cache_lookup(afl, trace_hash);
+
+    if (cached) {
+
+      ++afl->path_cache_hits;
+
+      if (likely(--afl->path_cache_left)) {
+
+        if (likely(afl->n_fuzz[cached->cksum % N_FUZZ_SIZE] < 0xFFFFFFFF)) {
+
+          afl->n_fuzz[cached->cksum % N_FUZZ_SIZE]++;
+
+        }
+
+        if (unlikely(afl->crash_mode)) { ++afl->total_crashes; }
+        return 0;
+
+      }
+
+      afl->path_cache_left = path_cache_interval(afl);
+
+    }
+
+  }
 
   /* Update path frequency. */
 
@@ -487,7 +593,7 @@ save_if_interesting(afl_state_t *afl, void *mem, u32 len, u8 fault) {
      only be used for special schedules */
   if (likely(afl->schedule >= FAST && afl->schedule <= RARE)) {
 
-    classify_counts(&afl->fsrv);
+    if (likely(!classified)) { classify_counts(&afl->fsrv); }
     classified = 1;
     need_hash = 0;
 
@@ -518,11 +624,31 @@ save_if_interesting(afl_state_t *afl, void *mem, u32 len, u8 fault) {
 
     if (likely(!new_bits)) {
 
+      if (unlikely(trace_hash)) {
+
+        if (unlikely(cached && cached->cksum != cksum)) {
+
+          ++afl->path_cache_collisions;
+
+        }
+
+        path_cache_insert(afl, trace_hash, cksum);
+
+      }
+
       if (unlikely(afl->crash_mode)) { ++afl->total_crashes; }
       return 0;
 
     }
 
+    /* A cached path can never have new bits - the hit was a collision. */
+    if (unlikely(cached)) {
+
+      ++afl->path_cache_collisions;
+      cached->trace_hash = 0;
+
+    }
+
   save_to_queue:
 
 #ifndef SIMPLE_FILES
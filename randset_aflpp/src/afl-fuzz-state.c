@@ -338,6 +338,13 @@ void read_afl_environment(afl_state_t *afl, char **envp) {
             afl->afl_env.afl_ignore_timeouts =
                 get_afl_env(afl_environment_variables[i]) ? 1 : 0;
 
+          } else if (!strncmp(env, "AFL_PATH_CACHE",
+
+                              afl_environment_variable_len)) {
+
+            afl->afl_env.afl_path_cache =
+                get_afl_env(afl_environment_variables[i]) ? 1 : 0;
+
           } else if (!strncmp(env, "AFL_I_DONT_CARE_ABOUT_MISSING_CRASHES",
 
                               afl_environment_variable_len)) {
@@ -730,6 +737,7 @@ void afl_state_deinit(afl_state_t *afl) {
   ck_free(afl->global_frontier_bitmap_searched);
   ck_free(afl->initial_frontier_bitmap);
   ck_free(afl->local_covered);
+  ck_free(afl->path_cache);
 
   list_remove(&afl_states, afl);
 
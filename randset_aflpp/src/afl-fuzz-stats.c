@@ -384,6 +384,15 @@ void write_stats_file(afl_state_t *afl, u32 t_bytes, double bitmap_cvg,
           : "default",
       afl->orig_cmdline);
 
+  if (afl->path_cache) {
+
+    fprintf(f,
+            "path_cache_hits   : %llu\n"
+            "path_cache_colls  : %llu\n",
+            afl->path_cache_hits, afl->path_cache_collisions);
+
+  }
+
   /* ignore errors */
 
   if (afl->debug) {
@@ -283,6 +283,7 @@ static void usage(u8 *argv0, int more_help) {
       "AFL_IGNORE_UNKNOWN_ENVS: don't warn on unknown env vars\n"
       "AFL_IMPORT_FIRST: sync and import test cases from other fuzzer instances first\n"
       "AFL_INPUT_LEN_MIN/AFL_INPUT_LEN_MAX: like -g/-G set min/max fuzz length produced\n"
+      "AFL_PATH_CACHE: skip the new-coverage scan for recently seen boring paths\n"
       "AFL_PIZZA_MODE: 1 - enforce pizza mode, -1 - disable for April 1st,\n"
       "                0 (default) - activate on April 1st\n"
       "AFL_KILL_SIGNAL: Signal ID delivered to child processes on timeout, etc.\n"
@@ -1635,6 +1636,27 @@ int main(int argc, char **argv_orig, char **envp) {
 
   }
 
+  /* The cache only pays for its hashing when the schedule hashes the map
+     anyway; the others keep the cheaper has_new_bits_unclassified(). */
+  if (afl->afl_env.afl_path_cache) {
+
+    if (afl->schedule >= FAST && afl->schedule <= RARE) {
+
+      afl->path_cache = ck_alloc((1U << PATH_CACHE_SIZE_POW2) *
+                                 sizeof(struct path_cache_entry));
+      afl->path_cache_left = PATH_CACHE_VALIDATE_MIN;
+      OKF("Path hash cache enabled (%u slots).", 1U << PATH_CACHE_SIZE_POW2);
+
+    } else {
+
+      WARNF(
+          "AFL_PATH_CACHE only works with -p fast/coe/lin/quad/rare, "
+          "ignoring it.");
+
+    }
+
+  }
+
   if (get_afl_env("AFL_NO_FORKSRV")) { afl->no_forkserver = 1; }
   if (get_afl_env("AFL_NO_CPU_RED")) { afl->no_cpu_meter_red = 1; }
   if (get_afl_env("AFL_NO_ARITH")) { afl->no_arith = 1; }
@@ -57,6 +57,7 @@
 #include <dirent.h>
 #include <sys/wait.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #ifndef USEMMAP
   #include <sys/shm.h>
 #endif
@@ -102,6 +103,78 @@ static bool quiet_mode,                /* Hide non-essential messages?      */
 static volatile u8 stop_soon,          /* Ctrl-C pressed?                   */
     child_crashed;                     /* Child crashed?                    */
 
+/* Cover mode (-M) and parallel collection (-j). Inputs are enumerated up
+   front so that they can be handed out to several forkservers, each one
+   running in its own worker process with its own map and input file. */
+
+#define COVER_NONE 0
+#define COVER_GREEDY 1
+#define COVER_RANDOM 2
+#define COVER_FRONTIER 3
+
+#define COVER_DISTINCT_TRIES 16        /* attempts at a not yet seen cover  */
+
+struct showmap_input {
+
+  u8 *path;                            /* input file                        */
+  u32 len;                             /* file size                         */
+  u32 cnt;                             /* features in cover_arena, 0 = none */
+  u64 off;                             /* offset of the encoded features    */
+
+};
+
+struct showmap_shared {
+
+  u32 next;                            /* next input handed out to a worker */
+  u32 highest;                         /* highest tuple value seen          */
+  u64 total;                           /* sum of all tuple values           */
+  u64 execs;                           /* executions done by all workers    */
+  u32 tuples;                          /* most tuples written for one input */
+  u8  have_coverage;                   /* any worker saw coverage           */
+  u8  maps[];                          /* one coverage map per worker (-C),
+                                          followed by the -F table          */
+
+};
+
+struct showmap_edge_freq {
+
+  u64 inputs;                          /* inputs that hit the edge          */
+  u64 hits;                            /* sum of the edge's hit counts      */
+
+};
+
+static struct showmap_input *inputs;   /* inputs to process with -M/-j/-F   */
+static u32 inputs_cnt, inputs_size;
+
+static struct showmap_shared *shared;  /* work queue and results of workers */
+static struct showmap_edge_freq *edge_freq;      /* -F table, NULL if unset */
+static u8 *edge_freq_file;                       /* -F output file          */
+static u8 *frontier_cfg;               /* AFL_CFG_PATH for the -C report    */
+
+static u32 jobs = 1,                   /* number of parallel forkservers    */
+    cover_mode = COVER_NONE,           /* -M cover algorithm                */
+    cover_num = 1;                     /* number of randomized covers       */
+
+static u8 *cover_arena,                /* delta + varint coded feature sets */
+    *cover_union,                      /* bit per feature seen by any input */
+    *cover_edges,                      /* edges hit by any input            */
+    *cover_universe;                   /* bit per feature a cover must hit  */
+static u64 cover_arena_len, cover_arena_size, cover_rand_state;
+static u32 cover_feat_cnt;             /* distinct features in cover_union  */
+static u32 *cover_feats;               /* scratch: features of one input    */
+static afl_cfg_t cover_cfg;            /* AFL_CFG_PATH, for frontier edges  */
+
+/* Input enumeration, workers (-j), covers (-M) and reports (-F, -C with
+   AFL_CFG_PATH), defined after main(). */
+
+static void setup_shmem_fuzz(afl_forkserver_t *fsrv);
+static void collect_inputs(u8 *dir);
+static void collect_inputs_filelist(u8 *fn);
+static void run_inputs(char **use_argv);
+static void write_edge_freq(void);
+static u32  cover_finish(void);
+static void frontier_report(void);
+
 static sharedmem_t       shm;
 static afl_forkserver_t *fsrv;
 static sharedmem_t      *shm_fuzz;
@@ -409,6 +482,26 @@ void pre_afl_fsrv_write_to_testcase(afl_forkserver_t *fsrv, u8 *mem, u32 len) {
 
 }
 
+/* Add the edges of the last run to the -F table. Called before the map is
+   classified, so that hits are the raw hit counts. */
+
+static void count_edge_freq(afl_forkserver_t *fsrv) {
+
+  u32 i;
+
+  for (i = 0; i < map_size; i++) {
+
+    if (fsrv->trace_bits[i]) {
+
+      edge_freq[i].inputs++;
+      edge_freq[i].hits += fsrv->trace_bits[i];
+
+    }
+
+  }
+
+}
+
 /* Execute target application. */
 
 static void showmap_run_target_forkserver(afl_forkserver_t *fsrv, u8 *mem,
@@ -436,6 +529,8 @@ static void showmap_run_target_forkserver(afl_forkserver_t *fsrv, u8 *mem,
 
   }
 
+  if (edge_freq) { count_edge_freq(fsrv); }
+
   if (!no_classify) { classify_counts(fsrv); }
 
   if (!quiet_mode) { SAYF(cRST "-- Program output ends --\n"); }
@@ -1025,6 +1120,20 @@ static void usage(u8 *argv0) {
       "  -C         - collect coverage, writes all edges to -o and gives a "
       "summary\n"
       "               Must be combined with -i.\n"
+      "  -M algo    - write a minimal cover of the -i/-I inputs to the -o "
+      "directory,\n"
+      "               algo: greedy (smallest), random (RandSet randomized) "
+      "or\n"
+      "               frontier (randomized, covers the frontier edges of "
+      "AFL_CFG_PATH)\n"
+      "  -n num     - with -M random/frontier: write num distinct covers to "
+      "-o/cover_*\n"
+      "               (fewer if no new one turns up in a few attempts)\n"
+      "  -j num     - with -i/-I: run num forkservers in parallel\n"
+      "  -F file    - with -i/-I: write a CSV table of how many inputs hit "
+      "each edge\n"
+      "               and how often in total (raw hit counts, wrap at 255 "
+      "per run)\n"
       "  -q         - sink program's output and don't show messages\n"
       "  -e         - show edge coverage only, ignore hit counts\n"
       "  -r         - show real tuple values instead of AFL filter values\n"
@@ -1043,6 +1152,9 @@ static void usage(u8 *argv0) {
       "AFL_CMIN_CRASHES_ONLY: (cmin_mode) only write tuples for crashing "
       "inputs\n"
       "AFL_CMIN_ALLOW_ANY: (cmin_mode) write tuples for crashing inputs also\n"
+      "AFL_CFG_PATH: CFG of the target, used by -M frontier, with -C also "
+      "writes a\n"
+      "              frontier report next to the -o file\n"
       "AFL_CRASH_EXITCODE: optional child exit code to be interpreted as "
       "crash\n"
       "AFL_DEBUG: enable extra developer output\n"
@@ -1096,7 +1208,8 @@ int main(int argc, char **argv_orig, char **envp) {
 
   if (getenv("AFL_QUIET") != NULL) { be_quiet = true; }
 
-  while ((opt = getopt(argc, argv, "+i:I:o:f:m:t:AeqCZOH:QUWbcrshXY")) > 0) {
+  while ((opt = getopt(argc, argv, "+i:I:o:f:m:t:j:M:n:F:AeqCZOH:QUWbcrshXY")) >
+         0) {
 
     switch (opt) {
 
@@ -1109,6 +1222,54 @@ int main(int argc, char **argv_orig, char **envp) {
         quiet_mode = true;
         break;
 
+      case 'M':
+        if (cover_mode) { FATAL("Multiple -M options not supported"); }
+        if (!strcmp(optarg, "greedy")) {
+
+          cover_mode = COVER_GREEDY;
+
+        } else if (!strcmp(optarg, "random")) {
+
+          cover_mode = COVER_RANDOM;
+
+        } else if (!strcmp(optarg, "frontier")) {
+
+          cover_mode = COVER_FRONTIER;
+
+        } else {
+
+          FATAL("Unknown cover algorithm '%s' for -M", optarg);
+
+        }
+
+        quiet_mode = true;
+        break;
+
+      case 'n':
+        cover_num = atoi(optarg);
+        if (cover_num < 1 || cover_num > 1000) {
+
+          FATAL("-n needs a value between 1 and 1000");
+
+        }
+
+        break;
+
+      case 'j':
+        jobs = atoi(optarg);
+        if (jobs < 1 || jobs > 4096) {
+
+          FATAL("-j needs a value between 1 and 4096");
+
+        }
+
+        break;
+
+      case 'F':
+        if (edge_freq_file) { FATAL("Multiple -F options not supported"); }
+        edge_freq_file = optarg;
+        break;
+
       case 'i':
         if (in_dir) { FATAL("Multiple -i options not supported"); }
         in_dir = optarg;
@@ -1350,6 +1511,37 @@ int main(int argc, char **argv_orig, char **envp) {
 
   }
 
+  if (cover_mode) {
+
+    if (!in_dir && !in_filelist) { FATAL("-M needs -i or -I"); }
+    if (collect_coverage) { FATAL("-M and -C are mutually exclusive"); }
+    if (raw_instr_output || no_classify || binary_mode) {
+
+      FATAL("-M cannot be combined with -r, -s or -b");
+
+    }
+
+  }
+
+  if (cover_num > 1 &&
+      (cover_mode == COVER_NONE || cover_mode == COVER_GREEDY)) {
+
+    FATAL("-n needs -M random or -M frontier");
+
+  }
+
+  if (collect_coverage && (in_dir || in_filelist)) {
+
+    frontier_cfg = get_afl_env("AFL_CFG_PATH");
+
+  }
+
+  if ((jobs > 1 || edge_freq_file) && !in_dir && !in_filelist) {
+
+    FATAL("-j and -F need -i or -I");
+
+  }
+
   if (fsrv->qemu_mode && !mem_limit_given) { fsrv->mem_limit = MEM_LIMIT_QEMU; }
   if (unicorn_mode && !mem_limit_given) { fsrv->mem_limit = MEM_LIMIT_UNICORN; }
 
@@ -1527,23 +1719,7 @@ int main(int argc, char **argv_orig, char **envp) {
   if (in_dir) { (void)check_binary_signatures(fsrv->target_path); }
 #endif
 
-  shm_fuzz = ck_alloc(sizeof(sharedmem_t));
-
-  /* initialize cmplog_mode */
-  shm_fuzz->cmplog_mode = 0;
-  u8 *map = afl_shm_init(shm_fuzz, MAX_FILE + sizeof(u32), 1);
-  shm_fuzz->shmemfuzz_mode = true;
-  if (!map) { FATAL("BUG: Zero return from afl_shm_init."); }
-#ifdef USEMMAP
-  setenv(SHM_FUZZ_ENV_VAR, shm_fuzz->g_shm_file_path, 1);
-#else
-  u8 *shm_str = alloc_printf("%d", shm_fuzz->shm_id);
-  setenv(SHM_FUZZ_ENV_VAR, shm_str, 1);
-  ck_free(shm_str);
-#endif
-  fsrv->support_shmem_fuzz = true;
-  fsrv->shmem_fuzz_len = (u32 *)map;
-  fsrv->shmem_fuzz = map + sizeof(u32);
+  setup_shmem_fuzz(fsrv);
 
   configure_afl_kill_signals(fsrv, NULL, NULL,
                              (fsrv->qemu_mode || unicorn_mode
@@ -1702,7 +1878,49 @@ int main(int argc, char **argv_orig, char **envp) {
     if (fsrv->support_shmem_fuzz && !fsrv->use_shmem_fuzz)
       shm_fuzz = deinit_shmem(fsrv, shm_fuzz);
 
-    if (in_dir) {
+    if (cover_mode || jobs > 1 || edge_freq_file || frontier_cfg) {
+
+      if (edge_freq_file) {
+
+        edge_freq = ck_alloc((u64)map_size * sizeof(struct showmap_edge_freq));
+
+      }
+
+      if (in_dir) {
+
+        collect_inputs(in_dir);
+
+      } else {
+
+        collect_inputs_filelist(in_filelist);
+
+      }
+
+      if (!inputs_cnt) {
+
+        FATAL("could not read input testcases from %s",
+              in_dir ? in_dir : in_filelist);
+
+      }
+
+      if (cover_mode) {
+
+        s32 fd = open("/dev/urandom", O_RDONLY);
+        if (fd < 0 || read(fd, &cover_rand_state, sizeof(u64)) != sizeof(u64)) {
+
+          cover_rand_state = get_cur_time_us() ^ getpid();
+
+        }
+
+        if (fd >= 0) { close(fd); }
+
+      }
+
+      run_inputs(use_argv);
+
+      if (edge_freq) { write_edge_freq(); }
+
+    } else if (in_dir) {
 
       if (execute_testcases(in_dir) == 0) {
 
@@ -1729,8 +1947,12 @@ int main(int argc, char **argv_orig, char **envp) {
       memcpy(fsrv->trace_bits, coverage_map, map_size);
       tcnt = write_results_to_file(fsrv, out_file);
 
+      if (frontier_cfg) { frontier_report(); }
+
     }
 
+    if (cover_mode) { tcnt = cover_finish(); }
+
   } else {
 
     if (fsrv->support_shmem_fuzz && !fsrv->use_shmem_fuzz)
@@ -1812,3 +2034,1190 @@ int main(int argc, char **argv_orig, char **envp) {
 
 }
 
+/* Set up the shared memory test case delivery for the current forkserver. */
+
+static void setup_shmem_fuzz(afl_forkserver_t *fsrv) {
+
+  shm_fuzz = ck_alloc(sizeof(sharedmem_t));
+
+  /* initialize cmplog_mode */
+  shm_fuzz->cmplog_mode = 0;
+  u8 *map = afl_shm_init(shm_fuzz, MAX_FILE + sizeof(u32), 1);
+  shm_fuzz->shmemfuzz_mode = true;
+  if (!map) { FATAL("BUG: Zero return from afl_shm_init."); }
+#ifdef USEMMAP
+  setenv(SHM_FUZZ_ENV_VAR, shm_fuzz->g_shm_file_path, 1);
+#else
+  u8 *shm_str = alloc_printf("%d", shm_fuzz->shm_id);
+  setenv(SHM_FUZZ_ENV_VAR, shm_str, 1);
+  ck_free(shm_str);
+#endif
+  fsrv->support_shmem_fuzz = true;
+  fsrv->shmem_fuzz_len = (u32 *)map;
+  fsrv->shmem_fuzz = map + sizeof(u32);
+
+}
+
+/* Enumerate the inputs below a directory or in a file list, with the same
+   filters as execute_testcases() and execute_testcases_filelist(). */
+
+static void add_input(u8 *path, u64 len) {
+
+  if (inputs_cnt == inputs_size) {
+
+    inputs_size = inputs_size ? inputs_size << 1 : 1024;
+    inputs = realloc(inputs, inputs_size * sizeof(struct showmap_input));
+    if (!inputs) { PFATAL("realloc() failed"); }
+
+  }
+
+  inputs[inputs_cnt].path = path;
+  inputs[inputs_cnt].len = len > MAX_FILE ? MAX_FILE : len;
+  inputs[inputs_cnt].cnt = 0;
+  inputs[inputs_cnt].off = 0;
+  ++inputs_cnt;
+
+}
+
+static void collect_inputs(u8 *dir) {
+
+  struct dirent **nl;
+  s32             nl_cnt;
+  u32             i;
+
+  nl_cnt = scandir(dir, &nl, NULL, alphasort);
+
+  if (nl_cnt < 0) { return; }
+
+  for (i = 0; i < (u32)nl_cnt; ++i) {
+
+    struct stat st;
+
+    u8 *fn2 = alloc_printf("%s/%s", dir, nl[i]->d_name);
+
+    if (lstat(fn2, &st) || access(fn2, R_OK)) {
+
+      PFATAL("Unable to access '%s'", fn2);
+
+    }
+
+    if (S_ISDIR(st.st_mode) && nl[i]->d_name[0] != '.') {
+
+      collect_inputs(fn2);
+      ck_free(fn2);
+
+    } else if (S_ISREG(st.st_mode) && st.st_size) {
+
+      add_input(fn2, st.st_size);
+
+    } else {
+
+      ck_free(fn2);
+
+    }
+
+    free(nl[i]);                                             /* not tracked */
+
+  }
+
+  free(nl);                                                  /* not tracked */
+
+}
+
+static void collect_inputs_filelist(u8 *fn) {
+
+  u8    buf[4096];
+  FILE *f;
+
+  if ((f = fopen(fn, "r")) == NULL) { FATAL("could not open '%s'", fn); }
+
+  while (fgets(buf, sizeof(buf), f) != NULL) {
+
+    struct stat st;
+    u8         *fn2 = buf;
+    u32         len;
+
+    while (*fn2 == ' ') {
+
+      ++fn2;
+
+    }
+
+    len = strlen(fn2);
+    while (len && (fn2[len - 1] == '\r' || fn2[len - 1] == '\n' ||
+                   fn2[len - 1] == ' ')) {
+
+      fn2[--len] = 0;
+
+    }
+
+    if (!*fn2) { continue; }
+
+    if (lstat(fn2, &st) || access(fn2, R_OK)) {
+
+      WARNF("Unable to access '%s'", fn2);
+      continue;
+
+    }
+
+    if (!S_ISREG(st.st_mode) || !st.st_size) { continue; }
+
+    add_input(ck_strdup(fn2), st.st_size);
+
+  }
+
+  fclose(f);
+
+}
+
+/* Cover features are the edge id shifted left by three, ORed with the hit
+   count bucket (0..7) of the human readable count classes. With -e every
+   bucket is 0, so features are plain edges. */
+
+static u32 cover_extract(afl_forkserver_t *fsrv) {
+
+  u32 i, cnt = 0;
+
+  for (i = 0; i < map_size; i++) {
+
+    if (fsrv->trace_bits[i]) {
+
+      /* -C maps hold raw counts, the frontier report only needs edges. */
+      cover_feats[cnt++] =
+          collect_coverage ? i << 3 : (i << 3) | (fsrv->trace_bits[i] - 1);
+
+    }
+
+  }
+
+  return cnt;
+
+}
+
+/* Append the sorted feature set of an input to the arena as varint coded
+   deltas - typically a byte or two per feature. */
+
+static void cover_index_add(u32 idx, u32 *feats, u32 cnt) {
+
+  u64 need = cover_arena_len + (u64)cnt * 5;
+  u32 i, prev = 0;
+  u8 *ptr;
+
+  if (need > cover_arena_size) {
+
+    if (!cover_arena_size) { cover_arena_size = 1 << 20; }
+    while (cover_arena_size < need) {
+
+      cover_arena_size <<= 1;
+
+    }
+
+    cover_arena = realloc(cover_arena, cover_arena_size);
+    if (!cover_arena) { PFATAL("realloc() failed"); }
+
+  }
+
+  inputs[idx].off = cover_arena_len;
+  inputs[idx].cnt = cnt;
+  ptr = cover_arena + cover_arena_len;
+
+  for (i = 0; i < cnt; i++) {
+
+    u32 delta = feats[i] - prev;
+    prev = feats[i];
+
+    while (delta >= 0x80) {
+
+      *ptr++ = (delta & 0x7f) | 0x80;
+      delta >>= 7;
+
+    }
+
+    *ptr++ = delta;
+
+    if (!BITMAP_CHECK(cover_union, feats[i])) {
+
+      BITMAP_SET(cover_union, feats[i]);
+      ++cover_feat_cnt;
+
+    }
+
+    cover_edges[feats[i] >> 3] = 1;
+
+  }
+
+  cover_arena_len = ptr - cover_arena;
+
+}
+
+static u32 cover_decode(u32 idx, u32 *feats) {
+
+  u8 *ptr = cover_arena + inputs[idx].off;
+  u32 i, prev = 0;
+
+  for (i = 0; i < inputs[idx].cnt; i++) {
+
+    u32 delta = 0, shift = 0;
+
+    while (*ptr & 0x80) {
+
+      delta |= (u32)(*ptr++ & 0x7f) << shift;
+      shift += 7;
+
+    }
+
+    delta |= (u32)*ptr++ << shift;
+    prev += delta;
+    feats[i] = prev;
+
+  }
+
+  return inputs[idx].cnt;
+
+}
+
+/* Write the -F table: one line per edge hit by any input. */
+
+static void write_edge_freq(void) {
+
+  FILE *f;
+  u32   i, cnt = 0;
+
+  if (!strcmp(edge_freq_file, "-")) {
+
+    f = fdopen(dup(1), "w");
+
+  } else {
+
+    unlink(edge_freq_file);                                /* Ignore errors */
+    f = fopen(edge_freq_file, "w");
+
+  }
+
+  if (!f) { PFATAL("Unable to create '%s'", edge_freq_file); }
+
+  fprintf(f, "edge,inputs,hits\n");
+
+  for (i = 0; i < map_size; i++) {
+
+    if (!edge_freq[i].inputs) { continue; }
+    fprintf(f, "%u,%llu,%llu\n", i, edge_freq[i].inputs, edge_freq[i].hits);
+    cnt++;
+
+  }
+
+  if (fclose(f)) { PFATAL("Unable to write '%s'", edge_freq_file); }
+
+  if (!quiet_mode) {
+
+    OKF("Wrote the frequencies of %u edges to '%s'.", cnt, edge_freq_file);
+
+  }
+
+}
+
+/* Index the features of the last run, through a worker's record file if
+   rec_f is set. */
+
+static void cover_record(u32 idx, FILE *rec_f) {
+
+  u32 cnt = cover_extract(fsrv);
+  if (!cnt) { return; }
+
+  if (rec_f) {
+
+    if (fwrite(&idx, sizeof(u32), 1, rec_f) != 1 ||
+        fwrite(&cnt, sizeof(u32), 1, rec_f) != 1 ||
+        fwrite(cover_feats, sizeof(u32), cnt, rec_f) != cnt) {
+
+      PFATAL("Unable to write cover records");
+
+    }
+
+  } else {
+
+    cover_index_add(idx, cover_feats, cnt);
+
+  }
+
+}
+
+/* Execute one enumerated input. Workers append cover records to rec_f, the
+   parent process indexes them directly. */
+
+static void run_input(u32 idx, FILE *rec_f) {
+
+  static s8 cco = -1, caa;
+
+  if (cco < 0) {
+
+    cco = !!getenv("AFL_CMIN_CRASHES_ONLY");
+    caa = !!getenv("AFL_CMIN_ALLOW_ANY");
+
+  }
+
+  if (!read_file(inputs[idx].path)) {
+
+    ck_free(in_data);
+    return;
+
+  }
+
+  showmap_run_target_forkserver(fsrv, in_data, in_len);
+  ck_free(in_data);
+
+  if (child_crashed && debug) { WARNF("crashed: %s", inputs[idx].path); }
+
+  /* Same selection as afl-cmin: no timeouts, crashes only on request. */
+  u8 selected = !fsrv->last_run_timed_out && (caa || child_crashed == cco);
+
+  if (collect_coverage) {
+
+    analyze_results(fsrv);
+    if (frontier_cfg && selected) { cover_record(idx, rec_f); }
+    return;
+
+  }
+
+  if (!cover_mode) {
+
+    u8 *fn = strrchr(inputs[idx].path, '/');
+    u8  out[PATH_MAX];
+    u32 cnt;
+
+    snprintf(out, sizeof(out), "%s/%s", out_file,
+             fn ? fn + 1 : inputs[idx].path);
+    cnt = write_results_to_file(fsrv, out);
+    if (cnt > tcnt) { tcnt = cnt; }
+    return;
+
+  }
+
+  if (selected) { cover_record(idx, rec_f); }
+
+}
+
+/* Size of the shared area of -j workers, and where the -F table lives. */
+
+static u64 shared_maps_size(void) {
+
+  return collect_coverage ? ((u64)jobs * map_size + 7) & ~7ULL : 0;
+
+}
+
+static u64 shared_size(void) {
+
+  return sizeof(struct showmap_shared) + shared_maps_size() +
+         (edge_freq ? (u64)map_size * sizeof(struct showmap_edge_freq) : 0);
+
+}
+
+static struct showmap_edge_freq *shared_edge_freq(void) {
+
+  return (struct showmap_edge_freq *)(shared->maps + shared_maps_size());
+
+}
+
+/* A worker process: its own input file, map and forkserver, pulling input
+   indices from the shared counter until all are handed out. */
+
+static void run_worker(u32 id, char **use_argv) {
+
+  u8   *old_file = stdin_file;
+  u32   old_len = strlen(old_file), i, idx, h;
+  FILE *rec_f = NULL;
+
+  /* Substitute our own input file for the parent's one in @@ arguments. */
+
+  stdin_file = alloc_printf("%s.%u", old_file, id);
+
+  for (i = 0; use_argv[i]; i++) {
+
+    u8 *loc = strstr(use_argv[i], old_file);
+
+    if (loc) {
+
+      use_argv[i] =
+          alloc_printf("%.*s.%u%s", (int)(loc - (u8 *)use_argv[i] + old_len),
+                       use_argv[i], id, loc + old_len);
+
+    }
+
+  }
+
+  unlink(stdin_file);
+  fsrv->out_file = stdin_file;
+  fsrv->out_fd =
+      open(stdin_file, O_RDWR | O_CREAT | O_EXCL, DEFAULT_PERMISSION);
+  if (fsrv->out_fd < 0) { PFATAL("Unable to create '%s'", stdin_file); }
+
+  fsrv->trace_bits = afl_shm_init(&shm, map_size, 0);
+  fsrv->use_shmem_fuzz = 0;
+  setup_shmem_fuzz(fsrv);
+
+  u32 save_be_quiet = be_quiet;
+  be_quiet = !debug;
+  afl_fsrv_start(fsrv, use_argv, &stop_soon,
+                 (get_afl_env("AFL_DEBUG_CHILD") ||
+                  get_afl_env("AFL_DEBUG_CHILD_OUTPUT"))
+                     ? 1
+                     : 0);
+  be_quiet = save_be_quiet;
+
+  if (fsrv->support_shmem_fuzz && !fsrv->use_shmem_fuzz) {
+
+    shm_fuzz = deinit_shmem(fsrv, shm_fuzz);
+
+  }
+
+  if (cover_mode || frontier_cfg) {
+
+    u8 *rec_fn = alloc_printf("%s.cover", stdin_file);
+    rec_f = fopen(rec_fn, "w");
+    if (!rec_f) { PFATAL("Unable to create '%s'", rec_fn); }
+    ck_free(rec_fn);
+
+  }
+
+  while ((idx = __atomic_fetch_add(&shared->next, 1, __ATOMIC_RELAXED)) <
+         inputs_cnt) {
+
+    run_input(idx, rec_f);
+
+  }
+
+  if (rec_f && fclose(rec_f)) { PFATAL("Unable to write cover records"); }
+
+  if (collect_coverage) {
+
+    memcpy(shared->maps + (u64)id * map_size, coverage_map, map_size);
+
+  }
+
+  if (edge_freq) {
+
+    struct showmap_edge_freq *freq = shared_edge_freq();
+
+    for (i = 0; i < map_size; i++) {
+
+      if (!edge_freq[i].inputs) { continue; }
+      __atomic_fetch_add(&freq[i].inputs, edge_freq[i].inputs,
+                         __ATOMIC_RELAXED);
+      __atomic_fetch_add(&freq[i].hits, edge_freq[i].hits, __ATOMIC_RELAXED);
+
+    }
+
+  }
+
+  __atomic_fetch_add(&shared->total, total, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&shared->execs, fsrv->total_execs, __ATOMIC_RELAXED);
+  if (have_coverage) { shared->have_coverage = 1; }
+
+  h = __atomic_load_n(&shared->tuples, __ATOMIC_RELAXED);
+  while (h < tcnt &&
+         !__atomic_compare_exchange_n(&shared->tuples, &h, tcnt, 0,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+
+  h = __atomic_load_n(&shared->highest, __ATOMIC_RELAXED);
+  while (h < highest &&
+         !__atomic_compare_exchange_n(&shared->highest, &h, highest, 0,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+
+  exit(0);
+
+}
+
+/* Read back the cover records a worker wrote. */
+
+static void read_worker_records(u32 id) {
+
+  u8   *rec_fn = alloc_printf("%s.%u.cover", stdin_file, id);
+  FILE *rec_f = fopen(rec_fn, "r");
+  u32   idx, cnt;
+
+  if (!rec_f) { PFATAL("Unable to open '%s'", rec_fn); }
+
+  while (fread(&idx, sizeof(u32), 1, rec_f) == 1) {
+
+    if (fread(&cnt, sizeof(u32), 1, rec_f) != 1 || idx >= inputs_cnt ||
+        cnt > map_size ||
+        fread(cover_feats, sizeof(u32), cnt, rec_f) != cnt) {
+
+      FATAL("Corrupt cover records in '%s'", rec_fn);
+
+    }
+
+    cover_index_add(idx, cover_feats, cnt);
+
+  }
+
+  fclose(rec_f);
+  unlink(rec_fn);
+  ck_free(rec_fn);
+
+}
+
+/* Run all enumerated inputs, with -j spread over several forkservers. Each
+   worker writes its per-file maps itself, -C maps, -F tables and totals are
+   merged here. */
+
+static void run_inputs(char **use_argv) {
+
+  u32    i;
+  pid_t *pids;
+
+  if (cover_mode || frontier_cfg) {
+
+    cover_feats = ck_alloc(map_size * sizeof(u32));
+    cover_union = ck_alloc(map_size);
+    cover_edges = ck_alloc(map_size);
+
+  }
+
+  if (jobs > inputs_cnt) { jobs = inputs_cnt; }
+
+  if (jobs <= 1) {
+
+    for (i = 0; i < inputs_cnt; i++) {
+
+      run_input(i, NULL);
+
+    }
+
+    return;
+
+  }
+
+  if (!be_quiet) { ACTF("Spawning %u forkservers...", jobs); }
+
+  shared = mmap(NULL, shared_size(), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) { PFATAL("mmap() failed"); }
+
+  /* Every worker starts a forkserver of its own. */
+  afl_fsrv_kill(fsrv);
+
+  fflush(stdout);
+  fflush(stderr);
+
+  pids = ck_alloc(jobs * sizeof(pid_t));
+
+  for (i = 0; i < jobs; i++) {
+
+    pids[i] = fork();
+    if (pids[i] < 0) { PFATAL("fork() failed"); }
+    if (!pids[i]) { run_worker(i, use_argv); }
+
+  }
+
+  for (i = 0; i < jobs; i++) {
+
+    int status;
+
+    if (waitpid(pids[i], &status, 0) <= 0) { PFATAL("waitpid() failed"); }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+
+      FATAL("Worker %u failed", i);
+
+    }
+
+  }
+
+  ck_free(pids);
+
+  if (collect_coverage) {
+
+    u32 j;
+
+    for (i = 0; i < jobs; i++) {
+
+      u8 *map = shared->maps + (u64)i * map_size;
+
+      for (j = 0; j < map_size; j++) {
+
+        coverage_map[j] |= map[j];
+
+      }
+
+    }
+
+  }
+
+  if (cover_mode || frontier_cfg) {
+
+    for (i = 0; i < jobs; i++) {
+
+      read_worker_records(i);
+
+    }
+
+  }
+
+  if (edge_freq) {
+
+    memcpy(edge_freq, shared_edge_freq(),
+           (u64)map_size * sizeof(struct showmap_edge_freq));
+
+  }
+
+  total += shared->total;
+  if (shared->highest > highest) { highest = shared->highest; }
+  if (shared->tuples > tcnt) { tcnt = shared->tuples; }
+  if (shared->have_coverage) { have_coverage = true; }
+  fsrv->total_execs += shared->execs;
+
+  munmap(shared, shared_size());
+  shared = NULL;
+
+}
+
+static u64 cover_rand(void) {
+
+  u64 z = (cover_rand_state += 0x9e3779b97f4a7c15ULL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+
+}
+
+/* The element of the universe a feature stands for: frontier covers only
+   care about edges, the others about edge + hit count bucket. */
+
+static inline u32 cover_key(u32 feat) {
+
+  return cover_mode == COVER_FRONTIER ? (feat & ~7U) : feat;
+
+}
+
+static u32 cover_build_universe(void) {
+
+  u32 i, b, cnt = 0;
+
+  cover_universe = ck_alloc(map_size);
+
+  for (i = 0; i < map_size; i++) {
+
+    if (!cover_edges[i]) { continue; }
+
+    if (cover_mode == COVER_FRONTIER) {
+
+      if (afl_cfg_is_frontier(&cover_cfg, cover_edges, i)) {
+
+        u32 feat = i << 3;
+        BITMAP_SET(cover_universe, feat);
+        ++cnt;
+
+      }
+
+    } else {
+
+      for (b = 0; b < 8; b++) {
+
+        u32 feat = (i << 3) | b;
+
+        if (BITMAP_CHECK(cover_union, feat)) {
+
+          BITMAP_SET(cover_universe, feat);
+          ++cnt;
+
+        }
+
+      }
+
+    }
+
+  }
+
+  return cnt;
+
+}
+
+/* Number of universe elements an input hits that are not covered yet;
+   marks them covered if take is set. */
+
+static u32 cover_gain(u32 idx, u8 *covered, u8 take) {
+
+  u32 i, cnt = cover_decode(idx, cover_feats), gain = 0;
+
+  for (i = 0; i < cnt; i++) {
+
+    u32 key = cover_key(cover_feats[i]);
+
+    if (BITMAP_CHECK(cover_universe, key) && !BITMAP_CHECK(covered, key)) {
+
+      ++gain;
+      if (take) { BITMAP_SET(covered, key); }
+
+    }
+
+  }
+
+  return gain;
+
+}
+
+/* Greedy set cover with lazy gain updates: gains only ever shrink, so a
+   popped entry whose refreshed gain still beats the next best is the true
+   maximum. Ties go to the smaller file, like in afl-cmin. */
+
+struct cover_heap_entry {
+
+  u32 gain;
+  u32 idx;
+
+};
+
+static inline u8 cover_heap_less(struct cover_heap_entry *a,
+                                 struct cover_heap_entry *b) {
+
+  if (a->gain != b->gain) { return a->gain < b->gain; }
+  return inputs[a->idx].len > inputs[b->idx].len;
+
+}
+
+static void cover_heap_down(struct cover_heap_entry *heap, u32 cnt, u32 i) {
+
+  while (1) {
+
+    u32 l = 2 * i + 1, r = l + 1, top = i;
+
+    if (l < cnt && cover_heap_less(&heap[top], &heap[l])) { top = l; }
+    if (r < cnt && cover_heap_less(&heap[top], &heap[r])) { top = r; }
+    if (top == i) { return; }
+
+    struct cover_heap_entry tmp = heap[i];
+    heap[i] = heap[top];
+    heap[top] = tmp;
+    i = top;
+
+  }
+
+}
+
+static u32 cover_greedy(u32 *sel, u8 *covered, u32 universe_cnt) {
+
+  struct cover_heap_entry *heap =
+      ck_alloc(inputs_cnt * sizeof(struct cover_heap_entry));
+  u32 i, cnt = 0, n = 0;
+
+  for (i = 0; i < inputs_cnt; i++) {
+
+    if (inputs[i].cnt) {
+
+      heap[cnt].gain = inputs[i].cnt;
+      heap[cnt++].idx = i;
+
+    }
+
+  }
+
+  for (i = cnt / 2; i-- > 0;) {
+
+    cover_heap_down(heap, cnt, i);
+
+  }
+
+  while (cnt && universe_cnt) {
+
+    heap[0].gain = cover_gain(heap[0].idx, covered, 0);
+
+    if (!heap[0].gain) {
+
+      heap[0] = heap[--cnt];
+      cover_heap_down(heap, cnt, 0);
+      continue;
+
+    }
+
+    if ((cnt > 1 && cover_heap_less(&heap[0], &heap[1])) ||
+        (cnt > 2 && cover_heap_less(&heap[0], &heap[2]))) {
+
+      cover_heap_down(heap, cnt, 0);
+      continue;
+
+    }
+
+    universe_cnt -= cover_gain(heap[0].idx, covered, 1);
+    sel[n++] = heap[0].idx;
+    heap[0] = heap[--cnt];
+    cover_heap_down(heap, cnt, 0);
+
+  }
+
+  ck_free(heap);
+  return n;
+
+}
+
+/* RandSet's randomized cover, as in set_cover_reduction_final(): walk the
+   inputs in random order and keep every one that hits an element not yet
+   covered, until the universe is covered. */
+
+static u32 cover_random(u32 *sel, u8 *covered, u32 universe_cnt) {
+
+  u32 *order = ck_alloc(inputs_cnt * sizeof(u32));
+  u32  i, cnt = 0, n = 0;
+
+  for (i = 0; i < inputs_cnt; i++) {
+
+    if (inputs[i].cnt) { order[cnt++] = i; }
+
+  }
+
+  /* Fisher-Yates Shuffle */
+  for (i = cnt; i > 1; i--) {
+
+    u32 j = cover_rand() % i;
+    SWAP(order[i - 1], order[j]);
+
+  }
+
+  for (i = 0; i < cnt && universe_cnt; i++) {
+
+    u32 gain = cover_gain(order[i], covered, 1);
+
+    if (gain) {
+
+      sel[n++] = order[i];
+      universe_cnt -= gain;
+
+    }
+
+  }
+
+  ck_free(order);
+  return n;
+
+}
+
+static int cover_cmp_u32(const void *a, const void *b) {
+
+  u32 x = *(const u32 *)a, y = *(const u32 *)b;
+  return x < y ? -1 : x > y;
+
+}
+
+/* Place a selected input into the output directory: hardlink if possible,
+   copy otherwise. */
+
+static void cover_copy(u8 *dir, u32 idx) {
+
+  u8 *src = inputs[idx].path, *name = strrchr(src, '/'), *dst;
+
+  name = name ? name + 1 : src;
+  dst = alloc_printf("%s/%s", dir, name);
+
+  if (!access(dst, F_OK)) {
+
+    ck_free(dst);
+    dst = alloc_printf("%s/id_%06u,%s", dir, idx, name);
+
+  }
+
+  if (link(src, dst)) {
+
+    s32 fd = open(src, O_RDONLY);
+    if (fd < 0) { PFATAL("Unable to open '%s'", src); }
+
+    in_data = ck_alloc_nozero(inputs[idx].len);
+    ck_read(fd, in_data, inputs[idx].len, src);
+    close(fd);
+
+    fd = open(dst, O_WRONLY | O_CREAT | O_EXCL, DEFAULT_PERMISSION);
+    if (fd < 0) { PFATAL("Unable to create '%s'", dst); }
+    ck_write(fd, in_data, inputs[idx].len, dst);
+    close(fd);
+    ck_free(in_data);
+
+  }
+
+  ck_free(dst);
+
+}
+
+/* Compute the cover(s) of the indexed inputs and write them to out_file.
+   Returns the size of the universe. */
+
+static u32 cover_finish(void) {
+
+  u32 *sel = ck_alloc(inputs_cnt * sizeof(u32));
+  u64 *seen = ck_alloc(cover_num * sizeof(u64));
+  u8  *covered = ck_alloc(map_size);
+  u32  universe_cnt, c, n, tries;
+
+  if (cover_mode == COVER_FRONTIER) {
+
+    u8 *cfg_path = get_afl_env("AFL_CFG_PATH");
+    if (!cfg_path) { FATAL("-M frontier needs AFL_CFG_PATH to be set"); }
+    afl_cfg_load(&cover_cfg, cfg_path, map_size);
+
+  }
+
+  universe_cnt = cover_build_universe();
+
+  if (!universe_cnt) {
+
+    if (cover_mode == COVER_FRONTIER) { FATAL("No frontier edges found"); }
+    FATAL("No instrumentation detected" cRST);
+
+  }
+
+  OKF("Indexed %u features of %u inputs in %llu kB, cover universe: %u %s.",
+      cover_feat_cnt, inputs_cnt, cover_arena_len >> 10, universe_cnt,
+      cover_mode == COVER_FRONTIER ? "frontier edges" : "tuples");
+
+  for (c = 0; c < cover_num; c++) {
+
+    u8 *dir = out_file;
+    u8  distinct = 0;
+
+    for (tries = 0; tries < COVER_DISTINCT_TRIES && !distinct; tries++) {
+
+      memset(covered, 0, map_size);
+
+      if (cover_mode == COVER_GREEDY) {
+
+        n = cover_greedy(sel, covered, universe_cnt);
+
+      } else {
+
+        n = cover_random(sel, covered, universe_cnt);
+
+      }
+
+      /* Retry if this randomized cover equals an earlier one. */
+
+      qsort(sel, n, sizeof(u32), cover_cmp_u32);
+      seen[c] = hash64((u8 *)sel, n * sizeof(u32), HASH_CONST);
+
+      u32 k;
+      for (k = 0; k < c && seen[k] != seen[c]; k++)
+        ;
+      distinct = k == c;
+
+    }
+
+    if (!distinct) {
+
+      WARNF("No new distinct cover in %u attempts, stopping after %u cover%s.",
+            COVER_DISTINCT_TRIES, c, c == 1 ? "" : "s");
+      break;
+
+    }
+
+    if (cover_num > 1) {
+
+      dir = alloc_printf("%s/cover_%03u", out_file, c);
+      if (mkdir(dir, 0700) && errno != EEXIST) {
+
+        PFATAL("cannot create output directory %s", dir);
+
+      }
+
+    }
+
+    for (u32 i = 0; i < n; i++) {
+
+      cover_copy(dir, sel[i]);
+
+    }
+
+    OKF("Wrote a cover of %u out of %u inputs to '%s'.", n, inputs_cnt, dir);
+
+    if (dir != out_file) { ck_free(dir); }
+
+  }
+
+  ck_free(covered);
+  ck_free(seen);
+  ck_free(sel);
+  return universe_cnt;
+
+}
+
+/* Decode the edges of an input into cover_feats, keeping frontier edges. */
+
+static u32 frontier_filter(u32 idx, u32 *owners) {
+
+  u32 j, k = 0, cnt = cover_decode(idx, cover_feats);
+
+  for (j = 0; j < cnt; j++) {
+
+    u32 e = cover_feats[j] >> 3;
+    if (owners[e]) { cover_feats[k++] = e; }
+
+  }
+
+  return k;
+
+}
+
+/* Write a path as a quoted CSV field followed by the separator, doubling
+   any quotes in it. */
+
+static void frontier_write_csv_path(FILE *f, u8 *path) {
+
+  fputc('"', f);
+
+  for (; *path; path++) {
+
+    if (*path == '"') { fputc('"', f); }
+    fputc(*path, f);
+
+  }
+
+  fputs("\",", f);
+
+}
+
+/* Frontier report of -C with AFL_CFG_PATH: the frontier edges of the whole
+   corpus (as is_frontier_node_outer() would see them after loading it) with
+   the number of inputs hitting each, and the frontier edges of every input.
+   Text mode writes <out>.frontier.csv and <out>.frontier_inputs.csv, -b a
+   single <out>.frontier file:
+
+     "AFLFRNT1", u32 map_size, u32 edges, u32 inputs,
+     edges  x { u32 edge, u32 owners },
+     inputs x { u32 name_len, name, u32 cnt, u32 edge[cnt] }
+
+   Only inputs owning at least one frontier edge are listed. Like with -M,
+   inputs that time out, and crashing ones unless AFL_CMIN_* says otherwise,
+   are left out. */
+
+static void frontier_report(void) {
+
+  u32 *owners = ck_alloc(map_size * sizeof(u32));
+  u32  i, j, cnt, edge_cnt = 0, input_cnt = 0;
+
+  afl_cfg_load(&cover_cfg, frontier_cfg, map_size);
+
+  for (i = 0; i < inputs_cnt; i++) {
+
+    cnt = cover_decode(i, cover_feats);
+
+    for (j = 0; j < cnt; j++) {
+
+      ++owners[cover_feats[j] >> 3];
+
+    }
+
+  }
+
+  for (i = 0; i < map_size; i++) {
+
+    if (!owners[i]) { continue; }
+
+    if (afl_cfg_is_frontier(&cover_cfg, cover_edges, i)) {
+
+      ++edge_cnt;
+
+    } else {
+
+      owners[i] = 0;
+
+    }
+
+  }
+
+  if (binary_mode) {
+
+    u8 *fn = alloc_printf("%s.frontier", out_file);
+    s32 fd;
+
+    unlink(fn);                                            /* Ignore errors */
+    fd = open(fn, O_WRONLY | O_CREAT | O_EXCL, DEFAULT_PERMISSION);
+    if (fd < 0) { PFATAL("Unable to create '%s'", fn); }
+
+    for (i = 0; i < inputs_cnt; i++) {
+
+      cnt = frontier_filter(i, owners);
+      if (cnt) { ++input_cnt; }
+
+    }
+
+    u32 hdr[3] = {map_size, edge_cnt, input_cnt};
+    ck_write(fd, "AFLFRNT1", 8, fn);
+    ck_write(fd, hdr, sizeof(hdr), fn);
+
+    for (i = 0; i < map_size; i++) {
+
+      if (!owners[i]) { continue; }
+      u32 rec[2] = {i, owners[i]};
+      ck_write(fd, rec, sizeof(rec), fn);
+
+    }
+
+    for (i = 0; i < inputs_cnt; i++) {
+
+      cnt = frontier_filter(i, owners);
+      if (!cnt) { continue; }
+
+      u32 len = strlen(inputs[i].path);
+      ck_write(fd, &len, sizeof(u32), fn);
+      ck_write(fd, inputs[i].path, len, fn);
+      ck_write(fd, &cnt, sizeof(u32), fn);
+      ck_write(fd, cover_feats, cnt * sizeof(u32), fn);
+
+    }
+
+    close(fd);
+    ck_free(fn);
+
+  } else {
+
+    u8   *fn = alloc_printf("%s.frontier.csv", out_file);
+    FILE *f = fopen(fn, "w");
+
+    if (!f) { PFATAL("Unable to create '%s'", fn); }
+
+    fprintf(f, "edge,owners\n");
+
+    for (i = 0; i < map_size; i++) {
+
+      if (owners[i]) { fprintf(f, "%u,%u\n", i, owners[i]); }
+
+    }
+
+    if (fclose(f)) { PFATAL("Unable to write '%s'", fn); }
+    ck_free(fn);
+
+    fn = alloc_printf("%s.frontier_inputs.csv", out_file);
+    f = fopen(fn, "w");
+    if (!f) { PFATAL("Unable to create '%s'", fn); }
+
+    fprintf(f, "input,frontier_edges\n");
+
+    for (i = 0; i < inputs_cnt; i++) {
+
+      cnt = frontier_filter(i, owners);
+      if (!cnt) { continue; }
+
+      ++input_cnt;
+      frontier_write_csv_path(f, inputs[i].path);
+
+      for (j = 0; j < cnt; j++) {
+
+        fprintf(f, j ? " %u" : "%u", cover_feats[j]);
+
+      }
+
+      fputc('\n', f);
+
+    }
+
+    if (fclose(f)) { PFATAL("Unable to write '%s'", fn); }
+    ck_free(fn);
+
+  }
+
+  OKF("Frontier report: %u frontier edges, owned by %u of %u inputs.",
+      edge_cnt, input_cnt, inputs_cnt);
+
+  ck_free(owners);
+
+}
+
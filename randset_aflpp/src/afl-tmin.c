@@ -80,8 +80,14 @@ static u8 crash_mode,                  /* Crash-centric mode?               */
     exact_mode,                        /* Require path match for crashes?   */
     remove_out_file,                   /* remove out_file on exit?          */
     remove_shm = 1,                    /* remove shmem on exit?             */
+    frontier_mode,                     /* Preserve frontier edges (-F)?     */
     debug;                             /* debug mode                        */
 
+static u32 *frontier_edges,            /* Frontier edges of the input (-F)  */
+    frontier_cnt;
+
+static afl_cfg_t cfg;                  /* AFL_CFG_PATH control flow graph   */
+
 static volatile u8 stop_soon;          /* Ctrl-C pressed?                   */
 
 static afl_forkserver_t *fsrv;
@@ -208,6 +214,50 @@ static void at_exit_handler(void) {
 
 }
 
+/* A frontier edge of the current run: hit, with the map of the run as the
+   virgin map of afl_cfg_is_frontier(). */
+
+static u8 is_frontier_edge(u8 *trace_bits, u32 id) {
+
+  return trace_bits[id] && afl_cfg_is_frontier(&cfg, trace_bits, id);
+
+}
+
+/* -F oracle: on the first run record the frontier edges of the input, later
+   accept any run that still has all of them as frontier edges. */
+
+static u8 frontier_check(afl_forkserver_t *fsrv, u8 first_run) {
+
+  u32 i;
+
+  if (first_run) {
+
+    frontier_edges = ck_alloc(map_size * sizeof(u32));
+
+    for (i = 0; i < map_size; i++) {
+
+      if (is_frontier_edge(fsrv->trace_bits, i)) {
+
+        frontier_edges[frontier_cnt++] = i;
+
+      }
+
+    }
+
+    return 1;
+
+  }
+
+  for (i = 0; i < frontier_cnt; i++) {
+
+    if (!is_frontier_edge(fsrv->trace_bits, frontier_edges[i])) { return 0; }
+
+  }
+
+  return 1;
+
+}
+
 /* Read initial file. */
 
 static void read_initial_file(void) {
@@ -306,6 +356,26 @@ static u8 tmin_run_target(afl_forkserver_t *fsrv, u8 *mem, u32 len,
 
   }
 
+  if (frontier_mode) {
+
+    if (ret == FSRV_RUN_CRASH) {
+
+      /* Reported by main() after the dry run. */
+      if (first_run) { crash_mode = 1; }
+      missed_crashes++;
+      return 0;
+
+    }
+
+    if (ret == FSRV_RUN_NOINST) { FATAL("Binary not instrumented?"); }
+
+    if (frontier_check(fsrv, first_run)) { return 1; }
+
+    missed_paths++;
+    return 0;
+
+  }
+
   /* Handle crashing inputs depending on current mode. */
 
   if (ret == FSRV_RUN_CRASH) {
@@ -349,6 +419,41 @@ static u8 tmin_run_target(afl_forkserver_t *fsrv, u8 *mem, u32 len,
 
 }
 
+/* Character minimization of in_data[pos, pos + len) as a group test: zero
+   the whole range in one exec and only bisect the ranges that get rejected.
+   The frontier oracle accepts most bytes of typical seeds, so this needs far
+   fewer execs than trying one byte at a time. Returns the bytes replaced. */
+
+static u32 minimize_chars_batched(afl_forkserver_t *fsrv, u8 *tmp_buf, u32 pos,
+                                  u32 len) {
+
+  u32 i, cnt = 0;
+
+  for (i = pos; i < pos + len; i++) {
+
+    if (in_data[i] != '0') { cnt++; }
+
+  }
+
+  if (!cnt) { return 0; }
+
+  memcpy(tmp_buf, in_data, in_len);
+  memset(tmp_buf + pos, '0', len);
+
+  if (tmin_run_target(fsrv, tmp_buf, in_len, 0)) {
+
+    memset(in_data + pos, '0', len);
+    return cnt;
+
+  }
+
+  if (len == 1) { return 0; }
+
+  return minimize_chars_batched(fsrv, tmp_buf, pos, len / 2) +
+         minimize_chars_batched(fsrv, tmp_buf, pos + len / 2, len - len / 2);
+
+}
+
 /* Actually minimize! */
 
 static void minimize(afl_forkserver_t *fsrv) {
@@ -560,26 +665,41 @@ next_del_blksize:
 
   ACTF(cBRI "Stage #3: " cRST "Character minimization...");
 
-  memcpy(tmp_buf, in_data, in_len);
+  if (frontier_mode) {
 
-  for (i = 0; i < in_len; i++) {
+    for (i = 0; i < in_len; i += TMIN_FRONTIER_BATCH) {
 
-    u8 res, orig = tmp_buf[i];
+      alpha_del2 += minimize_chars_batched(
+          fsrv, tmp_buf, i, MIN((u32)TMIN_FRONTIER_BATCH, in_len - i));
 
-    if (orig == '0') { continue; }
-    tmp_buf[i] = '0';
+    }
 
-    res = tmin_run_target(fsrv, tmp_buf, in_len, 0);
+    if (alpha_del2) { changed_any = 1; }
 
-    if (res) {
+  } else {
 
-      in_data[i] = '0';
-      alpha_del2++;
-      changed_any = 1;
+    memcpy(tmp_buf, in_data, in_len);
 
-    } else {
+    for (i = 0; i < in_len; i++) {
+
+      u8 res, orig = tmp_buf[i];
+
+      if (orig == '0') { continue; }
+      tmp_buf[i] = '0';
+
+      res = tmin_run_target(fsrv, tmp_buf, in_len, 0);
+
+      if (res) {
 
-      tmp_buf[i] = orig;
+        in_data[i] = '0';
+        alpha_del2++;
+        changed_any = 1;
+
+      } else {
+
+        tmp_buf[i] = orig;
+
+      }
 
     }
 
@@ -798,10 +918,14 @@ static void usage(u8 *argv0) {
       "  -e            - solve for edge coverage only, ignore hit counts\n"
       "  -x            - treat non-zero exit codes as crashes\n\n"
       "  -H            - minimize a hang (hang mode)\n"
+      "  -F            - keep the frontier edges of the input in the "
+      "AFL_CFG_PATH CFG\n"
+      "                  instead of its exact path (RandSet seeds)\n"
 
       "For additional tips, please consult %s/README.md.\n\n"
 
       "Environment variables used:\n"
+      "AFL_CFG_PATH: CFG of the target, needed by -F\n"
       "AFL_CRASH_EXITCODE: optional child exit code to be interpreted as crash\n"
       "AFL_FORKSRV_INIT_TMOUT: time spent waiting for forkserver during startup (in ms)\n"
       "AFL_KILL_SIGNAL: Signal ID delivered to child processes on timeout, etc.\n"
@@ -846,7 +970,7 @@ int main(int argc, char **argv_orig, char **envp) {
 
   SAYF(cCYA "afl-tmin" VERSION cRST " by Michal Zalewski\n");
 
-  while ((opt = getopt(argc, argv, "+i:o:f:m:t:B:xeAOQUWXYHh")) > 0) {
+  while ((opt = getopt(argc, argv, "+i:o:f:m:t:B:xeAOQUWXYHFh")) > 0) {
 
     switch (opt) {
 
@@ -1035,6 +1159,12 @@ int main(int argc, char **argv_orig, char **envp) {
         hang_mode = 1;
         break;
 
+      case 'F':                                   /* frontier preservation */
+
+        if (frontier_mode) { FATAL("Multiple -F options not supported"); }
+        frontier_mode = 1;
+        break;
+
       case 'B':                                              /* load bitmap */
 
         /* This is a secret undocumented option! It is speculated to be useful
@@ -1159,6 +1289,12 @@ int main(int argc, char **argv_orig, char **envp) {
 
   }
 
+  if (frontier_mode && (hang_mode || exact_mode)) {
+
+    FATAL("-F cannot be combined with -H or AFL_TMIN_EXACT");
+
+  }
+
   SAYF("\n");
 
   if (getenv("AFL_FORKSRV_INIT_TMOUT")) {
@@ -1269,6 +1405,14 @@ int main(int argc, char **argv_orig, char **envp) {
   if (fsrv->support_shmem_fuzz && !fsrv->use_shmem_fuzz)
     shm_fuzz = deinit_shmem(fsrv, shm_fuzz);
 
+  if (frontier_mode) {
+
+    u8 *cfg_path = get_afl_env("AFL_CFG_PATH");
+    if (!cfg_path) { FATAL("-F needs AFL_CFG_PATH to be set"); }
+    afl_cfg_load(&cfg, cfg_path, map_size);
+
+  }
+
   ACTF("Performing dry run (mem limit = %llu MB, timeout = %u ms%s)...",
        fsrv->mem_limit, fsrv->exec_tmout, edges_only ? ", edges only" : "");
 
@@ -1295,6 +1439,20 @@ int main(int argc, char **argv_orig, char **envp) {
 
     OKF("Program hangs as expected, minimizing in " cCYA "hang" cRST " mode.");
 
+  } else if (frontier_mode) {
+
+    if (crash_mode) {
+
+      FATAL("Target binary crashes, -F needs an input that does not crash.");
+
+    }
+
+    if (!frontier_cnt) { FATAL("The input has no frontier edges in the CFG."); }
+
+    OKF("Input has %u frontier edge%s, minimizing in " cCYA "frontier" cRST
+        " mode.",
+        frontier_cnt, frontier_cnt == 1 ? "" : "s");
+
   } else if (!crash_mode) {
 
     OKF("Program terminates normally, minimizing in " cCYA "instrumented" cRST
@@ -323,17 +323,20 @@ const KnobId knob_mutate_or_crossover = Knobs::NewId("mutate_or_crossover");
 std::vector<ByteArray> ByteArrayMutator::MutateMany(
     const std::vector<MutationInputRef> &inputs, size_t num_mutants) {
   if (inputs.empty()) abort();
-  // TODO(xinhaoyuan): Consider metadata in other inputs instead of always the
-  // first one.
-  SetMetadata(inputs[0].metadata != nullptr ? *inputs[0].metadata
-                                            : ExecutionMetadata());
   size_t num_inputs = inputs.size();
+  const std::vector<size_t> num_mutants_per_input =
+      NumMutantsPerInput(inputs, num_mutants);
   std::vector<ByteArray> mutants;
   mutants.reserve(num_mutants);
 
   for (size_t i = 0; i < num_inputs; ++i) {
-    auto mutant = inputs[i].data;
-    for (size_t i = 0; i < num_mutants / num_inputs; ++i) {
+    if (num_mutants_per_input[i] == 0) continue;
+    // Prefer the CMP entries observed for this input: they are likely to
+    // guard its unexplored branches.
+    SetMetadata(inputs[i].metadata != nullptr ? *inputs[i].metadata
+                                              : ExecutionMetadata());
+    for (size_t j = 0; j < num_mutants_per_input[i]; ++j) {
+      auto mutant = inputs[i].data;
       if (mutant.size() <= max_len_ &&
           knobs_.GenerateBool(knob_mutate_or_crossover, rng_())) {
         // Do crossover only if the mutant is not over the max_len_.
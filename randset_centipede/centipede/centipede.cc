@@ -52,11 +52,14 @@
 #include <filesystem>  // NOLINT
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -104,19 +107,22 @@ using perf::RUsageProfiler;
 
 Centipede::Centipede(const Environment &env, CentipedeCallbacks &user_callbacks,
                      const BinaryInfo &binary_info,
-                     CoverageLogger &coverage_logger, std::atomic<Stats> &stats)
+                     CoverageLogger &coverage_logger,
+                     SharedCoverageFrontier &coverage_frontier,
+                     std::atomic<Stats> &stats)
     : env_(env),
       user_callbacks_(user_callbacks),
       rng_(env_.seed),
       // TODO(kcc): [impl] find a better way to compute frequency_threshold.
       fs_(env_.feature_frequency_threshold, env_.MakeDomainDiscardMask()),
-      coverage_frontier_(binary_info),
+      corpus_(env_.compress_corpus_features),
+      coverage_frontier_(coverage_frontier),
       binary_info_(binary_info),
       pc_table_(binary_info_.pc_table),
       symbols_(binary_info_.symbols),
       function_filter_(env_.function_filter, symbols_),
       coverage_logger_(coverage_logger),
-      global_selected_frontier_(binary_info.pc_table.size(), false),
+      frontier_covered_epoch_(binary_info.pc_table.size(), 0),
       stats_(stats),
       input_filter_path_(std::filesystem::path(TemporaryLocalDirPath())
                              .append("filter-input")),
@@ -175,14 +181,14 @@ void Centipede::CorpusFromFiles(const Environment &env, std::string_view dir) {
     const std::string corpus_file_path = corpus_file_paths.Shard(shard);
     size_t num_shard_bytes = 0;
     // Read the shard (if it exists), collect input hashes from it.
-    absl::flat_hash_set<std::string> existing_hashes;
+    absl::flat_hash_set<HashDigest> existing_hashes;
     if (RemotePathExists(corpus_file_path)) {
       auto reader = DefaultBlobFileReaderFactory();
       // May fail to open if file doesn't exist.
       reader->Open(corpus_file_path).IgnoreError();
       ByteSpan blob;
       while (reader->Read(blob).ok()) {
-        existing_hashes.insert(Hash(blob));
+        existing_hashes.insert(HashDigestOf(blob));
       }
     }
     // Add inputs to the current shard, if the shard doesn't have them already.
@@ -193,7 +199,8 @@ void Centipede::CorpusFromFiles(const Environment &env, std::string_view dir) {
     for (const auto &path : sharded_paths[shard]) {
       std::string input;
       CHECK_OK(RemoteFileGetContents(path, input));
-      if (input.empty() || existing_hashes.contains(Hash(input))) {
+      if (input.empty() ||
+          existing_hashes.contains(HashDigestOf(AsByteSpan(input)))) {
         ++inputs_ignored;
         continue;
       }
@@ -234,7 +241,7 @@ void Centipede::UpdateAndMaybeLogStats(std::string_view log_type,
       ExecStats{
           /*fuzz_time_sec=*/static_cast<uint64_t>(std::ceil(fuzz_time_secs)),
           /*num_executions*/ num_runs_,
-          /*num_target_crashes*/ static_cast<uint64_t>(num_crashes_),
+          /*num_target_crashes*/ static_cast<uint64_t>(num_crashes_.load()),
       },
       CovStats{
           /*num_covered_pcs=*/fs_.CountFeatures(fd::kPCs),
@@ -296,7 +303,7 @@ void Centipede::UpdateAndMaybeLogStats(std::string_view log_type,
   os << fs_;
   os << " corp: " << corpus_.NumActive() << "/" << corpus_.NumTotal();
   LogIfNotZero(coverage_frontier_.NumFunctionsInFrontier(), "fr");
-  LogIfNotZero(num_crashes_, "crash");
+  LogIfNotZero(num_crashes_.load(), "crash");
   os << " max/avg: " << max_corpus_size << "/" << avg_corpus_size << " "
      << corpus_.MemoryUsageString();
   os << " exec/s: "
@@ -380,7 +387,23 @@ bool Centipede::RunBatch(
     absl::Nullable<BlobFileWriter *> features_file,
     absl::Nullable<BlobFileWriter *> unconditional_features_file) {
   BatchResult batch_result;
-  bool success = ExecuteAndReportCrash(env_.binary, input_vec, batch_result);
+  if (!ExecuteBatch(input_vec, batch_result)) return false;
+  return AddBatchResult(input_vec, batch_result, corpus_file, features_file,
+                        unconditional_features_file);
+}
+
+bool Centipede::ExecuteBatch(const std::vector<ByteArray> &input_vec,
+                             BatchResult &batch_result) {
+  // The features can stay in the runner's outputs until AddBatchResult() if
+  // nothing else executes in between.
+  batch_result.set_share_features(env_.extra_binaries.empty() &&
+                                  !env_.pipelined_execution);
+  bool success = user_callbacks_.Execute(env_.binary, input_vec, batch_result);
+  if (!success) {
+    // ReportCrash() executes the inputs again.
+    batch_result.CopySharedFeatures();
+    ReportCrash(env_.binary, input_vec, batch_result);
+  }
   CHECK_EQ(input_vec.size(), batch_result.results().size());
 
   for (const auto &extra_binary : env_.extra_binaries) {
@@ -394,12 +417,49 @@ bool Centipede::RunBatch(
     RequestEarlyStop(EXIT_FAILURE);
     return false;
   }
+  return true;
+}
+
+bool Centipede::AddBatchResult(
+    const std::vector<ByteArray> &input_vec, BatchResult &batch_result,
+    absl::Nullable<BlobFileWriter *> corpus_file,
+    absl::Nullable<BlobFileWriter *> features_file,
+    absl::Nullable<BlobFileWriter *> unconditional_features_file) {
   CHECK_EQ(batch_result.results().size(), input_vec.size());
   num_runs_ += input_vec.size();
   bool batch_gained_new_coverage = false;
+  // The digests are of the features as executed: usable only if nothing needs
+  // the pruned features of uninteresting inputs or adds features, and if
+  // adding an input makes all its features seen.
+  const bool use_features_digests = unconditional_features_file == nullptr &&
+                                    !env_.use_pcpair_features &&
+                                    env_.feature_frequency_threshold != 0;
+  auto remember_features_digest = [&](uint64_t digest) {
+    if (!use_features_digests || digest == 0) return;
+    if (seen_features_digests_.size() >= kMaxSeenFeaturesDigests) {
+      seen_features_digests_.clear();
+    }
+    seen_features_digests_.insert(digest);
+  };
   for (size_t i = 0; i < input_vec.size(); i++) {
     if (ShouldStop()) break;
-    FeatureVec &fv = batch_result.results()[i].mutable_features();
+    ExecutionResult &result = batch_result.results()[i];
+    const uint64_t features_digest = result.features_digest();
+    // Features once seen stay seen: an input with the same features as an
+    // input that had no unseen ones has none either.
+    if (use_features_digests && features_digest != 0 &&
+        seen_features_digests_.contains(features_digest)) {
+      continue;
+    }
+    // Most inputs gain nothing: look at their shared features before copying
+    // them, unless every input needs its own copy anyway.
+    if (result.shares_features() && unconditional_features_file == nullptr &&
+        !env_.use_pcpair_features &&
+        fs_.CountUnseenFeatures(result.features_view()) == 0) {
+      remember_features_digest(features_digest);
+      continue;
+    }
+    FeatureVec &fv = result.mutable_features();
     bool function_filter_passed = function_filter_.filter(fv);
     bool input_gained_new_coverage = fs_.PruneFeaturesAndCountUnseen(fv) != 0;
     if (env_.use_pcpair_features && AddPcPairFeatures(fv) != 0)
@@ -408,16 +468,21 @@ bool Centipede::RunBatch(
       CHECK_OK(unconditional_features_file->Write(
           PackFeaturesAndHash(input_vec[i], fv)));
     }
+    if (!input_gained_new_coverage) remember_features_digest(features_digest);
     if (input_gained_new_coverage) {
       // TODO(kcc): [impl] add stats for filtered-out inputs.
       if (!InputPassesFilter(input_vec[i])) continue;
       fs_.IncrementFrequencies(fv);
+      // All the features of the input are seen now.
+      remember_features_digest(features_digest);
       LogFeaturesAsSymbols(fv);
       batch_gained_new_coverage = true;
       CHECK_GT(fv.size(), 0UL);
       if (function_filter_passed) {
-        corpus_.Add(input_vec[i], fv, batch_result.results()[i].metadata(), fs_,
-                    coverage_frontier_);
+        coverage_frontier_.AddCoverage(fv);
+        coverage_frontier_.Read([&](const CoverageFrontier &frontier) {
+          corpus_.Add(input_vec[i], fv, result.metadata(), fs_, frontier);
+        });
       }
       if (corpus_file != nullptr) {
         CHECK_OK(corpus_file->Write(input_vec[i]));
@@ -456,8 +521,11 @@ void Centipede::LoadShard(const Environment &load_env, size_t shard_index,
         VLOG(10) << "Adding input " << Hash(input)
                  << "; new features: " << num_new_features;
         fs_.IncrementFrequencies(input_features);
+        coverage_frontier_.AddCoverage(input_features);
         // TODO(kcc): cmp_args are currently not saved to disk and not reloaded.
-        corpus_.Add(input, input_features, {}, fs_, coverage_frontier_);
+        coverage_frontier_.Read([&](const CoverageFrontier &frontier) {
+          corpus_.Add(input, input_features, {}, fs_, frontier);
+        });
         ++num_added_inputs;
       } else {
         VLOG(10) << "Skipping input: " << Hash(input);
@@ -511,14 +579,52 @@ void Centipede::Rerun(std::vector<ByteArray> &to_rerun) {
   LOG(INFO) << to_rerun.size() << " inputs to rerun";
   // Re-run all inputs for which we don't know their features.
   // Run in batches of at most env_.batch_size inputs each.
-  while (!to_rerun.empty()) {
-    if (ShouldStop()) break;
+  auto next_batch = [&] {
     size_t batch_size = std::min(to_rerun.size(), env_.batch_size);
-    std::vector<ByteArray> batch(to_rerun.end() - batch_size, to_rerun.end());
+    std::vector<ByteArray> batch(
+        std::make_move_iterator(to_rerun.end() - batch_size),
+        std::make_move_iterator(to_rerun.end()));
     to_rerun.resize(to_rerun.size() - batch_size);
-    if (RunBatch(batch, nullptr, nullptr, features_file.get())) {
+    return batch;
+  };
+  auto add_batch_result = [&](const std::vector<ByteArray> &batch,
+                              BatchResult &batch_result) {
+    if (AddBatchResult(batch, batch_result, nullptr, nullptr,
+                       features_file.get())) {
       UpdateAndMaybeLogStats("rerun-old", 1);
     }
+  };
+
+  if (!env_.pipelined_execution) {
+    while (!to_rerun.empty()) {
+      if (ShouldStop()) break;
+      const std::vector<ByteArray> batch = next_batch();
+      BatchResult batch_result;
+      if (!ExecuteBatch(batch, batch_result)) continue;
+      add_batch_result(batch, batch_result);
+    }
+    return;
+  }
+  // As in FuzzingLoop(): while a batch executes on `execution_thread`, add the
+  // results of the previous one. The batches alternate between the two slots.
+  std::vector<ByteArray> batches[2];
+  BatchResult batch_results[2];
+  std::optional<size_t> executed_slot;
+  for (size_t slot = 0; !to_rerun.empty() && !ShouldStop(); slot ^= 1) {
+    batches[slot] = next_batch();
+    bool executed = false;
+    std::thread execution_thread([&] {
+      executed = ExecuteBatch(batches[slot], batch_results[slot]);
+    });
+    if (executed_slot.has_value()) {
+      add_batch_result(batches[*executed_slot], batch_results[*executed_slot]);
+    }
+    execution_thread.join();
+    executed_slot.reset();
+    if (executed) executed_slot = slot;
+  }
+  if (executed_slot.has_value()) {
+    add_batch_result(batches[*executed_slot], batch_results[*executed_slot]);
   }
 }
 
@@ -690,61 +796,160 @@ void Centipede::ReloadAllShardsAndWriteDistilledCorpus() {
   }
 }
 
-std::set<size_t> Centipede::DynamicSetConstruction() {
-  std::set<size_t> reduced_set;
-  std::vector<bool> covered_frontier_nodes(coverage_frontier_.MaxPcIndex(), false);
-  std::vector<size_t> shuffled_indexs(corpus_.NumActive());
-  std::iota(shuffled_indexs.begin(), shuffled_indexs.end(), 0);
-  std::shuffle(shuffled_indexs.begin(), shuffled_indexs.end(), rng_);
+absl::Span<const size_t> Centipede::DynamicSetConstruction() {
+  if (++frontier_epoch_ == 0) {
+    // The epoch wrapped around: stale stamps could match again.
+    std::fill(frontier_covered_epoch_.begin(), frontier_covered_epoch_.end(), 0);
+    frontier_epoch_ = 1;
+  }
+  shuffled_record_indices_.resize(corpus_.NumActive());
+  std::iota(shuffled_record_indices_.begin(), shuffled_record_indices_.end(), 0);
+  std::shuffle(shuffled_record_indices_.begin(), shuffled_record_indices_.end(),
+               rng_);
 
-  size_t total_frontier_num = coverage_frontier_.NumGlobalFrontierNodes();
+  reduced_set_.clear();
+  const size_t total_frontier_num = coverage_frontier_.NumGlobalFrontierNodes();
   size_t cur_frontier_num = 0;
-  for (auto index : shuffled_indexs) {
-    auto &record = corpus_.Records()[index];
-    auto &frontier_node_set = record.frontier_node_set;
-    for (auto &frontier_node_idx : frontier_node_set) {
-      if (!covered_frontier_nodes[frontier_node_idx]) {
-        covered_frontier_nodes[frontier_node_idx] = true;
-        ++ cur_frontier_num;
-        reduced_set.insert(index);                                       // use property of std::set
-        if (cur_frontier_num == total_frontier_num) return reduced_set;
+  for (auto index : shuffled_record_indices_) {
+    if (cur_frontier_num == total_frontier_num) break;
+    bool covers_new_frontier = false;
+    for (auto frontier_node_idx : corpus_.GetFrontierNodeSet(index)) {
+      if (frontier_covered_epoch_[frontier_node_idx] == frontier_epoch_) {
+        continue;
       }
+      frontier_covered_epoch_[frontier_node_idx] = frontier_epoch_;
+      ++cur_frontier_num;
+      covers_new_frontier = true;
     }
+    if (covers_new_frontier) reduced_set_.push_back(index);
   }
-  return reduced_set;
+  std::sort(reduced_set_.begin(), reduced_set_.end());
+  return reduced_set_;
 }
 
-std::set<size_t> Centipede::FirstMoverSelection(const std::set<size_t> &reduced_set, size_t num_seeds) {
-  std::set<size_t> selected_corpus_records;
-  std::set<size_t> tmp_candidate_set;
-  for (auto index : reduced_set) {
-    auto &record = corpus_.Records()[index];
-    auto &frontier_node_set = record.frontier_node_set;
-    for (auto &frontier_node_idx : frontier_node_set) {
-      if (!global_selected_frontier_[frontier_node_idx]) {
-        tmp_candidate_set.insert(index);
-        break;
+absl::Span<const size_t> Centipede::FirstMoverSelection(
+    absl::Span<const size_t> reduced_set, size_t num_seeds) {
+  frontier_selection_stamp_ = coverage_frontier_.BeginSelectionBatch();
+  auto collect_candidates = [&]() {
+    first_mover_candidates_.clear();
+    for (auto index : reduced_set) {
+      for (auto frontier_node_idx : corpus_.GetFrontierNodeSet(index)) {
+        if (!FrontierPcSelectedRecently(frontier_node_idx)) {
+          first_mover_candidates_.push_back(index);
+          break;
+        }
       }
     }
+  };
+  collect_candidates();
+  if (first_mover_candidates_.empty() && !reduced_set.empty() &&
+      env_.reset_frontier_selection_when_exhausted) {
+    // Every frontier PC was selected recently: start a new selection round.
+    coverage_frontier_.ResetSelections(frontier_selection_stamp_);
+    collect_candidates();
   }
 
-  const std::set<size_t> &final_candidate_set = tmp_candidate_set.empty() ? reduced_set : tmp_candidate_set;
-  std::vector<size_t> candidate_vec(final_candidate_set.begin(), final_candidate_set.end());
-
+  selected_records_.clear();
+  if (env_.weighted_first_mover_selection && !first_mover_candidates_.empty()) {
+    WeightedFirstMoverSelection(num_seeds);
+    std::sort(selected_records_.begin(), selected_records_.end());
+    return selected_records_;
+  }
 
+  const absl::Span<const size_t> candidates =
+      first_mover_candidates_.empty() ? reduced_set
+                                      : absl::MakeConstSpan(first_mover_candidates_);
+  if (candidates.empty()) return selected_records_;
   for (size_t i = 0; i < num_seeds; i++) {
-    size_t index = candidate_vec[rng_() % candidate_vec.size()];
-    selected_corpus_records.insert(index);
-    auto &record = corpus_.Records()[index];
-    auto &frontier_node_set = record.frontier_node_set;
-    for (auto &frontier_node_idx : frontier_node_set) {
-      global_selected_frontier_[frontier_node_idx] = true;
+    size_t index = candidates[rng_() % candidates.size()];
+    selected_records_.push_back(index);
+    for (auto frontier_node_idx : corpus_.GetFrontierNodeSet(index)) {
+      coverage_frontier_.MarkSelected(frontier_node_idx,
+                                      frontier_selection_stamp_);
     }
   }
+  std::sort(selected_records_.begin(), selected_records_.end());
+  selected_records_.erase(
+      std::unique(selected_records_.begin(), selected_records_.end()),
+      selected_records_.end());
+  return selected_records_;
+}
+
+void Centipede::SetFrontierMutationWeights(
+    absl::Span<const size_t> records,
+    std::vector<MutationInputRef> &inputs) const {
+  coverage_frontier_.Read([&](const CoverageFrontier &frontier) {
+    for (size_t i = 0; i < records.size(); ++i) {
+      uint64_t weight = 0;
+      for (auto frontier_node_idx : corpus_.GetFrontierNodeSet(records[i])) {
+        if (!coverage_frontier_.SelectedIn(frontier_node_idx,
+                                           frontier_selection_stamp_)) {
+          continue;
+        }
+        weight += FrontierSelectionWeight(frontier, frontier_node_idx);
+      }
+      inputs[i].weight = weight;
+    }
+  });
+}
 
-  return selected_corpus_records;
+uint64_t Centipede::FrontierSelectionWeight(const CoverageFrontier &frontier,
+                                            PCIndex pc_index) {
+  // FrontierWeight() may be 0, e.g. with no callees behind the frontier:
+  // count every frontier PC at least once.
+  return frontier.FrontierWeight(pc_index) + 1;
 }
 
+void Centipede::WeightedFirstMoverSelection(size_t num_seeds) {
+  const size_t num_candidates = first_mover_candidates_.size();
+  if (first_mover_slot_.size() < corpus_.NumActive()) {
+    first_mover_slot_.resize(corpus_.NumActive(), kNoFirstMoverSlot);
+  }
+  first_mover_initial_weights_.assign(num_candidates, 0);
+  coverage_frontier_.Read([&](const CoverageFrontier &frontier) {
+    for (size_t slot = 0; slot < num_candidates; ++slot) {
+      const size_t index = first_mover_candidates_[slot];
+      first_mover_slot_[index] = slot;
+      for (auto frontier_node_idx : corpus_.GetFrontierNodeSet(index)) {
+        if (FrontierPcSelectedRecently(frontier_node_idx)) continue;
+        first_mover_initial_weights_[slot] +=
+            FrontierSelectionWeight(frontier, frontier_node_idx);
+      }
+    }
+    first_mover_weights_.Assign(first_mover_initial_weights_);
+
+    // Every pick zeroes its own weight (no replacement) and takes its
+    // unselected frontier PCs' weights away from the other candidates having
+    // them, so that the next pick targets different frontiers. The own weight
+    // is zeroed explicitly: other threads may have selected some of its PCs
+    // meanwhile. Each weight change is a point update of the sum tree.
+    while (selected_records_.size() < num_seeds &&
+           first_mover_weights_.total_weight() != 0) {
+      const size_t slot = first_mover_weights_.RandomIndex(rng_());
+      const size_t index = first_mover_candidates_[slot];
+      selected_records_.push_back(index);
+      for (auto frontier_node_idx : corpus_.GetFrontierNodeSet(index)) {
+        if (FrontierPcSelectedRecently(frontier_node_idx)) continue;
+        coverage_frontier_.MarkSelected(frontier_node_idx,
+                                        frontier_selection_stamp_);
+        const uint64_t weight =
+            FrontierSelectionWeight(frontier, frontier_node_idx);
+        for (const uint32_t other : corpus_.RecordsWithPc(frontier_node_idx)) {
+          const uint32_t other_slot = first_mover_slot_[other];
+          if (other_slot == kNoFirstMoverSlot || other_slot == slot) continue;
+          const uint64_t other_weight = first_mover_weights_.weight(other_slot);
+          first_mover_weights_.SetWeight(
+              other_slot, other_weight - std::min(weight, other_weight));
+        }
+      }
+      first_mover_weights_.SetWeight(slot, 0);
+    }
+  });
+
+  for (const size_t index : first_mover_candidates_) {
+    first_mover_slot_[index] = kNoFirstMoverSlot;
+  }
+}
 
 void Centipede::LoadSeedInputs(absl::Nonnull<BlobFileWriter *> corpus_file,
                                absl::Nonnull<BlobFileWriter *> features_file) {
@@ -767,15 +972,16 @@ void Centipede::LoadSeedInputs(absl::Nonnull<BlobFileWriter *> corpus_file,
   // Forcely add all seed inputs to avoid empty corpus if none of them increased
   // coverage and passed the filters.
   if (corpus_.NumTotal() == 0) {
-    for (const auto &seed_input : seed_inputs)
-      corpus_.Add(seed_input, {}, {}, fs_, coverage_frontier_);
+    coverage_frontier_.Read([&](const CoverageFrontier &frontier) {
+      for (const auto &seed_input : seed_inputs)
+        corpus_.Add(seed_input, {}, {}, fs_, frontier);
+    });
   }
 }
 
 void Centipede::PrintSeedFrontierNodes() {
-  for (size_t i = 0; i < corpus_.Records().size(); ++i) {
-    auto &record = corpus_.Records()[i];
-    auto &frontier_node_set = record.frontier_node_set;
+  for (size_t i = 0; i < corpus_.NumActive(); ++i) {
+    auto &frontier_node_set = corpus_.GetFrontierNodeSet(i);
     printf("corpus record idx : %d\n", i);
     for (auto &frontier_node_idx : frontier_node_set) {
       printf("frontier node idx : %d\n", frontier_node_idx);
@@ -784,6 +990,56 @@ void Centipede::PrintSeedFrontierNodes() {
   }
 }
 
+std::vector<ByteArray> Centipede::MutateBatch(size_t batch_index,
+                                              size_t batch_size) {
+  std::vector<MutationInputRef> mutation_inputs;
+  mutation_inputs.reserve(env_.mutate_batch_size);              // select  mutate_batch_size seeds
+
+  // The global frontier set is kept up to date by RunBatch() and LoadShard()
+  // as inputs are added to the corpus.
+  if (batch_index > 0) {
+    // update frontier node set for each corpus record
+    coverage_frontier_.ReadChangesSince(
+        frontier_version_,
+        [&](const CoverageFrontier &frontier,
+            absl::Span<const PCIndex> changed_pcs) {
+          corpus_.UpdateFrontierNodeSetForCorpus(frontier, changed_pcs);
+        });
+    if (env_.weighted_first_mover_selection || env_.frontier_mutation_budget) {
+      coverage_frontier_.UpdateFrontierWeights(env_.frontier_threads);
+    }
+
+    // get reduced seed set via Dynamic Set Construction algorithm
+    absl::Span<const size_t> reduced_set = DynamicSetConstruction();
+
+    // PrintSeedFrontierNodes();
+
+    printf("corpus size : %zu   reduced set : %zu\n", corpus_.NumActive(), reduced_set.size());
+    // select seeds from reduced corpus
+    absl::Span<const size_t> selected_corpus_records = FirstMoverSelection(reduced_set, env_.mutate_batch_size);
+
+    for (auto index : selected_corpus_records) {
+      mutation_inputs.push_back(
+        MutationInputRef{corpus_.Get(index), &corpus_.GetMetadata(index)});
+    }
+    if (env_.frontier_mutation_budget) {
+      SetFrontierMutationWeights(selected_corpus_records, mutation_inputs);
+    }
+  }
+  // First batch, or no frontier to select by (e.g. no CFG): select randomly.
+  if (mutation_inputs.empty()) {
+    for (size_t i = 0; i < env_.mutate_batch_size; i++) {
+      const size_t index = env_.use_corpus_weights
+                               ? corpus_.WeightedRandomIndex(rng_())
+                               : corpus_.UniformRandomIndex(rng_());
+      mutation_inputs.push_back(
+          MutationInputRef{corpus_.Get(index), &corpus_.GetMetadata(index)});
+    }
+  }
+
+  return user_callbacks_.Mutate(mutation_inputs, batch_size);
+}
+
 void Centipede::FuzzingLoop() {
   LOG(INFO) << "Shard: " << env_.my_shard_index << "/" << env_.total_shards
             << " " << TemporaryLocalDirPath() << " "
@@ -833,50 +1089,20 @@ void Centipede::FuzzingLoop() {
   if (env_.num_runs % env_.batch_size != 0) ++number_of_batches;
   size_t new_runs = 0;
   size_t corpus_size_at_last_prune = corpus_.NumActive();
-  for (size_t batch_index = 0; batch_index < number_of_batches; batch_index++) {
-    if (ShouldStop()) break;
+  auto mutate_batch = [&](size_t batch_index) {
     CHECK_LT(new_runs, env_.num_runs);
     auto remaining_runs = env_.num_runs - new_runs;
     auto batch_size = std::min(env_.batch_size, remaining_runs);
-    std::vector<MutationInputRef> mutation_inputs;
-    mutation_inputs.reserve(env_.mutate_batch_size);              // select  mutate_batch_size seeds
-
-    // update global frontier set
-    coverage_frontier_.UpdateGlobalFrontierSet(corpus_.Records());
-
-    if (batch_index > 0) {
-      // update frontier node set for each corpus record
-      corpus_.UpdateFrontierNodeSetForCorpus(coverage_frontier_);
-
-      // get reduced seed set via Dynamic Set Construction algorithm
-      std::set<size_t> reduced_set = DynamicSetConstruction();
-
-      // PrintSeedFrontierNodes();
-
-      printf("corpus size : %d   reduced set : %d\n", corpus_.NumActive(), reduced_set.size());
-      // select seeds from reduced corpus
-      std::set<size_t> selected_corpus_records = FirstMoverSelection(reduced_set, env_.mutate_batch_size);
-
-      for (auto index : selected_corpus_records) {
-        const auto &corpus_record = corpus_.Records()[index];
-        mutation_inputs.push_back(
-          MutationInputRef{corpus_record.data, &corpus_record.metadata});
-      }
-    } else {
-      for (size_t i = 0; i < env_.mutate_batch_size; i++) {
-        const auto &corpus_record = env_.use_corpus_weights
-                                        ? corpus_.WeightedRandom(rng_())
-                                        : corpus_.UniformRandom(rng_());
-        mutation_inputs.push_back(
-            MutationInputRef{corpus_record.data, &corpus_record.metadata});
-      }
-    }
-
-    const std::vector<ByteArray> mutants =
-        user_callbacks_.Mutate(mutation_inputs, batch_size);
-    bool gained_new_coverage =
-        RunBatch(mutants, corpus_file.get(), features_file.get(), nullptr);
+    std::vector<ByteArray> mutants = MutateBatch(batch_index, batch_size);
     new_runs += mutants.size();
+    return mutants;
+  };
+  auto add_batch_result = [&](size_t batch_index,
+                              const std::vector<ByteArray> &mutants,
+                              BatchResult &batch_result) {
+    bool gained_new_coverage =
+        AddBatchResult(mutants, batch_result, corpus_file.get(),
+                       features_file.get(), nullptr);
 
     if (gained_new_coverage) {
       UpdateAndMaybeLogStats("new-feature", 1);
@@ -902,10 +1128,64 @@ void Centipede::FuzzingLoop() {
     if (env_.prune_frequency != 0 &&
         corpus_.NumActive() >
             corpus_size_at_last_prune + env_.prune_frequency) {
-      if (env_.use_coverage_frontier) coverage_frontier_.Compute(corpus_);
-      corpus_.Prune(fs_, coverage_frontier_, env_.max_corpus_size, rng_);
+      if (env_.use_coverage_frontier || env_.weighted_first_mover_selection) {
+        coverage_frontier_.UpdateFrontierWeights(env_.frontier_threads);
+      }
+      // The global frontier keeps the coverage of the pruned records, see
+      // CoverageFrontier::AddCoverage(). It is shared with the other threads,
+      // and a PC that some input reached once should not make its
+      // predecessors frontier PCs again.
+      coverage_frontier_.Read([&](const CoverageFrontier &frontier) {
+        corpus_.Prune(fs_, frontier, env_.max_corpus_size, rng_);
+      });
       corpus_size_at_last_prune = corpus_.NumActive();
     }
+  };
+
+  if (!env_.pipelined_execution) {
+    for (size_t batch_index = 0; batch_index < number_of_batches;
+         batch_index++) {
+      if (ShouldStop()) break;
+      const std::vector<ByteArray> mutants = mutate_batch(batch_index);
+      BatchResult batch_result;
+      if (!ExecuteBatch(mutants, batch_result)) continue;
+      add_batch_result(batch_index, mutants, batch_result);
+    }
+  } else if (number_of_batches != 0) {
+    // While batch `batch_index` executes on `execution_thread`, add the
+    // results of the previous batch and mutate the next one. The next batch
+    // is thus mutated from a corpus that misses the batch being executed.
+    std::vector<ByteArray> mutants = mutate_batch(0);
+    std::vector<ByteArray> executed_mutants;
+    // The batches alternate between the two results, which keep their storage.
+    BatchResult batch_results[2];
+    std::optional<size_t> executed_batch_index;
+    for (size_t batch_index = 0; batch_index < number_of_batches;
+         batch_index++) {
+      if (ShouldStop()) break;
+      BatchResult &batch_result = batch_results[batch_index % 2];
+      bool executed = false;
+      std::thread execution_thread([&] {
+        executed = ExecuteBatch(mutants, batch_result);
+      });
+      if (executed_batch_index.has_value()) {
+        add_batch_result(*executed_batch_index, executed_mutants,
+                         batch_results[*executed_batch_index % 2]);
+      }
+      std::vector<ByteArray> next_mutants;
+      if (batch_index + 1 < number_of_batches && !ShouldStop()) {
+        next_mutants = mutate_batch(batch_index + 1);
+      }
+      execution_thread.join();
+      executed_mutants = std::move(mutants);
+      executed_batch_index.reset();
+      if (executed) executed_batch_index = batch_index;
+      mutants = std::move(next_mutants);
+    }
+    if (executed_batch_index.has_value()) {
+      add_batch_result(*executed_batch_index, executed_mutants,
+                       batch_results[*executed_batch_index % 2]);
+    }
   }
 
   // The tests rely on this stat being logged last.
@@ -951,13 +1231,14 @@ void Centipede::ReportCrash(std::string_view binary,
   // Still report if time runs out.
   if (ShouldStop() && ExitCode() != 0) return;
 
-  if (++num_crashes_ > env_.max_num_crash_reports) return;
+  const int crash_index = ++num_crashes_;
+  if (crash_index > env_.max_num_crash_reports) return;
 
   const std::string log_prefix =
-      absl::StrCat("ReportCrash[", num_crashes_, "]: ");
+      absl::StrCat("ReportCrash[", crash_index, "]: ");
   log_execution_failure(log_prefix);
 
-  LOG_IF(INFO, num_crashes_ == env_.max_num_crash_reports)
+  LOG_IF(INFO, crash_index == env_.max_num_crash_reports)
       << log_prefix
       << "Reached --max_num_crash_reports: further reports will be suppressed";
 
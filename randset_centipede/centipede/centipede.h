@@ -17,12 +17,15 @@
 
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "./centipede/binary_info.h"
 #include "./centipede/centipede_callbacks.h"
 #include "./centipede/command.h"
@@ -32,9 +35,11 @@
 #include "./centipede/environment.h"
 #include "./centipede/feature.h"
 #include "./centipede/feature_set.h"
+#include "./centipede/mutation_input.h"
 #include "./centipede/pc_info.h"
 #include "./centipede/runner_result.h"
 #include "./centipede/rusage_profiler.h"
+#include "./centipede/shared_coverage_frontier.h"
 #include "./centipede/stats.h"
 #include "./centipede/symbol_table.h"
 #include "./centipede/workdir.h"
@@ -48,6 +53,7 @@ class Centipede {
  public:
   Centipede(const Environment &env, CentipedeCallbacks &user_callbacks,
             const BinaryInfo &binary_info, CoverageLogger &coverage_logger,
+            SharedCoverageFrontier &coverage_frontier,
             std::atomic<Stats> &stats);
   virtual ~Centipede() = default;
 
@@ -69,6 +75,9 @@ class Centipede {
   static void CorpusFromFiles(const Environment &env, std::string_view dir);
 
  private:
+  // Exercises the seed selection directly, see centipede_test.cc.
+  friend class CentipedeSeedSelectionTest;
+
   // Executes inputs from `input_vec`.
   // For every input, its pruned features are written to
   // `unconditional_features_file`, (if that's non-null).
@@ -82,6 +91,22 @@ class Centipede {
                 absl::Nullable<BlobFileWriter *> corpus_file,
                 absl::Nullable<BlobFileWriter *> features_file,
                 absl::Nullable<BlobFileWriter *> unconditional_features_file);
+  // The two halves of RunBatch(). ExecuteBatch() executes `input_vec` with
+  // env_.binary and env_.extra_binaries and reports the crashes; returns false
+  // if fuzzing should stop because of a crash. AddBatchResult() does the rest
+  // of RunBatch() with the results. With --pipelined_execution, ExecuteBatch()
+  // runs on its own thread, concurrently with AddBatchResult() and
+  // MutateBatch() for other batches: it must not touch the corpus.
+  bool ExecuteBatch(const std::vector<ByteArray> &input_vec,
+                    BatchResult &batch_result);
+  bool AddBatchResult(
+      const std::vector<ByteArray> &input_vec, BatchResult &batch_result,
+      absl::Nullable<BlobFileWriter *> corpus_file,
+      absl::Nullable<BlobFileWriter *> features_file,
+      absl::Nullable<BlobFileWriter *> unconditional_features_file);
+  // Selects the seeds for batch `batch_index` of the fuzzing loop and returns
+  // up to `batch_size` mutants of them.
+  std::vector<ByteArray> MutateBatch(size_t batch_index, size_t batch_size);
   // Loads seed inputs from the user callbacks, execute them, and store them
   // with the corresponding features into `corpus_file` and `features_file`.
   void LoadSeedInputs(absl::Nonnull<BlobFileWriter *> corpus_file,
@@ -98,7 +123,9 @@ class Centipede {
   void LoadAllShardsInRandomOrder(const Environment &load_env,
                                   bool rerun_my_shard);
   // Runs all inputs from `to_rerun`, adds their features to the features file
-  // of env_.my_shard_index, adds interesting inputs to the corpus.
+  // of env_.my_shard_index, adds interesting inputs to the corpus. With
+  // --pipelined_execution, adds the results of a batch while the next one
+  // executes.
   void Rerun(std::vector<ByteArray> &to_rerun);
 
   // Prints one logging line with `log_type` in it
@@ -167,11 +194,45 @@ class Centipede {
   // See more comments in centipede.cc.
   size_t AddPcPairFeatures(FeatureVec &fv);
 
-  // reduce corpus set via setcover algorithm
-  std::set<size_t> DynamicSetConstruction();
+  // Reduces the corpus to a random set of records covering all global
+  // frontier PCs (set cover). Returns sorted corpus record indices; the span
+  // stays valid until the next call.
+  absl::Span<const size_t> DynamicSetConstruction();
+
+  // Selects `num_seeds` records out of `reduced_set`, preferring the ones
+  // with frontier PCs not selected recently (see
+  // FrontierPcSelectedRecently()). Each call counts as one selection batch.
+  // Returns sorted unique corpus record indices; the span stays valid until
+  // the next call.
+  absl::Span<const size_t> FirstMoverSelection(
+      absl::Span<const size_t> reduced_set, size_t num_seeds);
+
+  // Implements FirstMoverSelection() for `env_.weighted_first_mover_selection`:
+  // appends to selected_records_ up to `num_seeds` distinct records out of
+  // first_mover_candidates_, each picked with probability proportional to the
+  // weight of its frontier PCs not selected yet. Stops early once no
+  // candidate has such PCs left.
+  void WeightedFirstMoverSelection(size_t num_seeds);
 
-  // first mover selection, return selected corpus records
-  std::set<size_t> FirstMoverSelection(const std::set<size_t> &reduced_set, size_t mutate_batch_size);
+  // Sets the weight of every `inputs[i]`, selected as corpus record
+  // `records[i]` by FirstMoverSelection(), to the total selection weight of
+  // the frontier PCs it was selected for in the current batch.
+  void SetFrontierMutationWeights(absl::Span<const size_t> records,
+                                  std::vector<MutationInputRef> &inputs) const;
+
+  // Returns the weight of frontier PC `pc_index` in `frontier` for seed
+  // selection.
+  static uint64_t FrontierSelectionWeight(const CoverageFrontier &frontier,
+                                          PCIndex pc_index);
+
+  // Returns true iff frontier PC `pc_index` was picked by
+  // FirstMoverSelection() of any thread within the last
+  // `env_.frontier_selection_window` batches (ever, if the window is 0) and
+  // since the last history reset.
+  bool FrontierPcSelectedRecently(PCIndex pc_index) const {
+    return coverage_frontier_.SelectedRecently(
+        pc_index, frontier_selection_stamp_, env_.frontier_selection_window);
+  }
 
 
   void PrintSeedFrontierNodes();
@@ -188,9 +249,19 @@ class Centipede {
 
   FeatureSet fs_;
   Corpus corpus_;
-  CoverageFrontier coverage_frontier_;
-  std::vector<bool> global_selected_frontier_;    // Global frontier node selection status
+  // The coverage frontier and the frontier selection history. This object is
+  // shared with other threads, it is thread-safe.
+  SharedCoverageFrontier &coverage_frontier_;
+  // The version of coverage_frontier_ changes applied to corpus_.
+  size_t frontier_version_ = 0;
+  // The stamp of the current FirstMoverSelection() batch.
+  size_t frontier_selection_stamp_ = 0;
   size_t num_runs_ = 0;  // counts executed inputs
+  // The runner's FeaturesDigest()s of feature vectors known to have no unseen
+  // features. RunBatch() skips the FeatureSet lookups for the inputs having
+  // one of these. Cleared when it reaches kMaxSeenFeaturesDigests.
+  absl::flat_hash_set<uint64_t> seen_features_digests_;
+  static constexpr size_t kMaxSeenFeaturesDigests = 1 << 20;
 
   // Binary-related data, initialized at startup, once per process,
   // by calling the PopulateBinaryInfo callback.
@@ -209,12 +280,33 @@ class Centipede {
   // Statistics of the current run.
   std::atomic<Stats> &stats_;
 
-  // Counts the number of crashes reported so far.
-  int num_crashes_ = 0;
+  // Counts the number of crashes reported so far. Atomic: with
+  // --pipelined_execution, crashes are reported on the execution thread.
+  std::atomic<int> num_crashes_ = 0;
 
   // Scratch object for AddPcPairFeatures.
   std::vector<size_t> add_pc_pair_scratch_;
 
+  // Scratch objects for DynamicSetConstruction() and FirstMoverSelection(),
+  // reused so that seed scheduling does not allocate once they have grown.
+  // A frontier PC is covered in the current DynamicSetConstruction() call iff
+  // frontier_covered_epoch_[pc_index] == frontier_epoch_, so nothing needs
+  // to be cleared between calls.
+  std::vector<uint32_t> frontier_covered_epoch_;
+  uint32_t frontier_epoch_ = 0;
+  std::vector<size_t> shuffled_record_indices_;
+  std::vector<size_t> reduced_set_;
+  std::vector<size_t> first_mover_candidates_;
+  std::vector<size_t> selected_records_;
+  // Scratch objects for WeightedFirstMoverSelection(). first_mover_slot_ maps
+  // a corpus record index to its position in first_mover_candidates_, or to
+  // kNoFirstMoverSlot; only candidate entries are ever set, and they are
+  // reset after use.
+  static constexpr uint32_t kNoFirstMoverSlot = ~0U;
+  std::vector<uint32_t> first_mover_slot_;
+  std::vector<uint64_t> first_mover_initial_weights_;
+  WeightedSumTree first_mover_weights_;
+
   // Path and command for the input_filter.
   std::string input_filter_path_;
   Command input_filter_cmd_;
@@ -75,6 +75,23 @@ std::vector<std::string> EnvironmentVariablesToUnset() {
 
 }  // namespace
 
+CentipedeCallbacks::RunnerIo::RunnerIo(const Environment &env,
+                                       std::string_view temp_dir,
+                                       std::string_view name)
+    : name(name),
+      execute_log_path(std::filesystem::path(temp_dir).append(
+          absl::StrCat(name, name.empty() ? "" : "_", "log"))),
+      failure_description_path(std::filesystem::path(temp_dir).append(
+          absl::StrCat(name, name.empty() ? "" : "_", "failure_description"))),
+      shmem_name1(ProcessAndThreadUniqueID(
+          name.empty() ? "/ctpd-shm1-" : "/ctpd-shm3-")),
+      shmem_name2(ProcessAndThreadUniqueID(
+          name.empty() ? "/ctpd-shm2-" : "/ctpd-shm4-")),
+      inputs_blobseq(shmem_name1.c_str(), env.shmem_size_mb << 20,
+                     env.use_posix_shmem),
+      outputs_blobseq(shmem_name2.c_str(), env.shmem_size_mb << 20,
+                      env.use_posix_shmem) {}
+
 void CentipedeCallbacks::PopulateBinaryInfo(BinaryInfo &binary_info) {
   binary_info.InitializeFromSanCovBinary(
       env_.coverage_binary, env_.objdump_path, env_.symbolizer_path, temp_dir_);
@@ -143,8 +160,8 @@ std::string CentipedeCallbacks::ConstructRunnerFlags(
 }
 
 Command &CentipedeCallbacks::GetOrCreateCommandForBinary(
-    std::string_view binary) {
-  for (auto &cmd : commands_) {
+    std::string_view binary, RunnerIo &io) {
+  for (auto &cmd : io.commands) {
     if (cmd.path() == binary) return cmd;
   }
   // We don't want to collect coverage for extra binaries. It won't be used.
@@ -153,9 +170,9 @@ Command &CentipedeCallbacks::GetOrCreateCommandForBinary(
                 binary) != env_.extra_binaries.end();
 
   std::vector<std::string> env = {ConstructRunnerFlags(
-      absl::StrCat(":shmem:arg1=", inputs_blobseq_.path(),
-                   ":arg2=", outputs_blobseq_.path(),
-                   ":failure_description_path=", failure_description_path_,
+      absl::StrCat(":shmem:arg1=", io.inputs_blobseq.path(),
+                   ":arg2=", io.outputs_blobseq.path(),
+                   ":failure_description_path=", io.failure_description_path,
                    ":"),
       disable_coverage)};
 
@@ -172,13 +189,16 @@ Command &CentipedeCallbacks::GetOrCreateCommandForBinary(
   Command::Options cmd_options;
   cmd_options.env_add = std::move(env);
   cmd_options.env_remove = EnvironmentVariablesToUnset();
-  cmd_options.stdout_file = execute_log_path_;
-  cmd_options.stderr_file = execute_log_path_;
+  cmd_options.stdout_file = io.execute_log_path;
+  cmd_options.stderr_file = io.execute_log_path;
   cmd_options.timeout = amortized_timeout;
+  cmd_options.persistent_batches = env_.fork_server_persistent_batches;
   cmd_options.temp_file_path = temp_input_file_path_;
   Command &cmd =
-      commands_.emplace_back(Command{binary, std::move(cmd_options)});
-  if (env_.fork_server) cmd.StartForkServer(temp_dir_, Hash(binary));
+      io.commands.emplace_back(Command{binary, std::move(cmd_options)});
+  if (env_.fork_server) {
+    cmd.StartForkServer(temp_dir_, absl::StrCat(io.name, Hash(binary)));
+  }
 
   return cmd;
 }
@@ -189,9 +209,10 @@ int CentipedeCallbacks::ExecuteCentipedeSancovBinaryWithShmem(
   auto start_time = absl::Now();
   batch_result.ClearAndResize(inputs.size());
 
+  RunnerIo &io = execution_io_;
   // Reset the blobseqs.
-  inputs_blobseq_.Reset();
-  outputs_blobseq_.Reset();
+  io.inputs_blobseq.Reset();
+  io.outputs_blobseq.Reset();
 
   size_t num_inputs_written = 0;
 
@@ -200,9 +221,9 @@ int CentipedeCallbacks::ExecuteCentipedeSancovBinaryWithShmem(
     WriteToLocalFile(temp_input_file_path_, inputs[0]);
     num_inputs_written = 1;
   } else {
-    // Feed the inputs to inputs_blobseq_.
+    // Feed the inputs to io.inputs_blobseq.
     num_inputs_written =
-        runner_request::RequestExecution(inputs, inputs_blobseq_);
+        runner_request::RequestExecution(inputs, io.inputs_blobseq);
   }
 
   if (num_inputs_written != inputs.size()) {
@@ -212,22 +233,26 @@ int CentipedeCallbacks::ExecuteCentipedeSancovBinaryWithShmem(
   }
 
   // Run.
-  Command &cmd = GetOrCreateCommandForBinary(binary);
+  Command &cmd = GetOrCreateCommandForBinary(binary, io);
   int retval = cmd.Execute();
-  inputs_blobseq_.ReleaseSharedMemory();  // Inputs are already consumed.
+  io.inputs_blobseq.ReleaseSharedMemory();  // Inputs are already consumed.
 
   // Get results.
   batch_result.exit_code() = retval;
-  const bool read_success = batch_result.Read(outputs_blobseq_);
+  const bool read_success = batch_result.Read(io.outputs_blobseq);
   LOG_IF(ERROR, !read_success) << "Failed to read batch result!";
-  outputs_blobseq_.ReleaseSharedMemory();  // Outputs are already consumed.
+  // Shared features are consumed later, and their memory is reused by the
+  // next execution.
+  if (!batch_result.share_features()) {
+    io.outputs_blobseq.ReleaseSharedMemory();  // Outputs are already consumed.
+  }
 
   // We may have fewer feature blobs than inputs if
   // * some inputs were not written (i.e. num_inputs_written < inputs.size).
   //   * Logged above.
   // * some outputs were not written because the subprocess died.
   //   * Will be logged by the caller.
-  // * some outputs were not written because the outputs_blobseq_ overflown.
+  // * some outputs were not written because the io.outputs_blobseq overflown.
   //   * Logged by the following code.
   if (retval == 0 && read_success &&
       batch_result.num_outputs_read() != num_inputs_written) {
@@ -237,15 +262,15 @@ int CentipedeCallbacks::ExecuteCentipedeSancovBinaryWithShmem(
               << env_.shmem_size_mb;
   }
 
-  if (env_.print_runner_log) PrintExecutionLog();
+  if (env_.print_runner_log) PrintExecutionLog(io);
 
   if (retval != EXIT_SUCCESS) {
-    ReadFromLocalFile(execute_log_path_, batch_result.log());
-    ReadFromLocalFile(failure_description_path_,
+    ReadFromLocalFile(io.execute_log_path, batch_result.log());
+    ReadFromLocalFile(io.failure_description_path,
                       batch_result.failure_description());
     // Remove failure_description_ here so that it doesn't stay until another
     // failed execution.
-    std::filesystem::remove(failure_description_path_);
+    std::filesystem::remove(io.failure_description_path);
   }
   VLOG(1) << __FUNCTION__ << " took " << (absl::Now() - start_time);
   return retval;
@@ -270,15 +295,15 @@ bool CentipedeCallbacks::GetSeedsViaExternalBinary(
   Command::Options cmd_options;
   cmd_options.env_add = {std::move(centipede_runner_flags)};
   cmd_options.env_remove = EnvironmentVariablesToUnset();
-  cmd_options.stdout_file = execute_log_path_;
-  cmd_options.stderr_file = execute_log_path_;
+  cmd_options.stdout_file = execution_io_.execute_log_path;
+  cmd_options.stderr_file = execution_io_.execute_log_path;
   cmd_options.temp_file_path = temp_input_file_path_;
   Command cmd{binary, std::move(cmd_options)};
   const int retval = cmd.Execute();
 
   if (env_.print_runner_log) {
     LOG(INFO) << "Getting seeds via external binary returns " << retval;
-    PrintExecutionLog();
+    PrintExecutionLog(execution_io_);
   }
 
   std::vector<std::string> seed_input_filenames;
@@ -317,8 +342,8 @@ bool CentipedeCallbacks::GetSerializedTargetConfigViaExternalBinary(
   Command::Options cmd_options;
   cmd_options.env_add = {std::move(centipede_runner_flags)};
   cmd_options.env_remove = EnvironmentVariablesToUnset();
-  cmd_options.stdout_file = execute_log_path_;
-  cmd_options.stderr_file = execute_log_path_;
+  cmd_options.stdout_file = execution_io_.execute_log_path;
+  cmd_options.stderr_file = execution_io_.execute_log_path;
   cmd_options.temp_file_path = temp_input_file_path_;
   Command cmd{binary, std::move(cmd_options)};
   const bool is_success = cmd.Execute() == 0;
@@ -331,7 +356,7 @@ bool CentipedeCallbacks::GetSerializedTargetConfigViaExternalBinary(
     }
   }
   if (env_.print_runner_log || !is_success) {
-    PrintExecutionLog();
+    PrintExecutionLog(execution_io_);
   }
   std::error_code error;
   std::filesystem::remove(config_file_path, error);
@@ -348,30 +373,31 @@ MutationResult CentipedeCallbacks::MutateViaExternalBinary(
       << "Standalone binary does not support custom mutator";
 
   auto start_time = absl::Now();
-  inputs_blobseq_.Reset();
-  outputs_blobseq_.Reset();
+  RunnerIo &io = mutation_io();
+  io.inputs_blobseq.Reset();
+  io.outputs_blobseq.Reset();
 
   size_t num_inputs_written =
-      runner_request::RequestMutation(num_mutants, inputs, inputs_blobseq_);
+      runner_request::RequestMutation(num_mutants, inputs, io.inputs_blobseq);
   LOG_IF(INFO, num_inputs_written != inputs.size())
       << VV(num_inputs_written) << VV(inputs.size());
 
   // Execute.
-  Command &cmd = GetOrCreateCommandForBinary(binary);
+  Command &cmd = GetOrCreateCommandForBinary(binary, io);
   int retval = cmd.Execute();
-  inputs_blobseq_.ReleaseSharedMemory();  // Inputs are already consumed.
+  io.inputs_blobseq.ReleaseSharedMemory();  // Inputs are already consumed.
 
   if (retval != EXIT_SUCCESS) {
     LOG(WARNING) << "Custom mutator failed with exit code " << retval;
   }
   if (env_.print_runner_log || retval != EXIT_SUCCESS) {
-    PrintExecutionLog();
+    PrintExecutionLog(io);
   }
 
   MutationResult result;
   result.exit_code() = retval;
-  result.Read(num_mutants, outputs_blobseq_);
-  outputs_blobseq_.ReleaseSharedMemory();  // Outputs are already consumed.
+  result.Read(num_mutants, io.outputs_blobseq);
+  io.outputs_blobseq.ReleaseSharedMemory();  // Outputs are already consumed.
 
   VLOG(1) << __FUNCTION__ << " took " << (absl::Now() - start_time);
   return result;
@@ -415,14 +441,14 @@ size_t CentipedeCallbacks::LoadDictionary(std::string_view dictionary_path) {
   return unpacked_dictionary.size();
 }
 
-void CentipedeCallbacks::PrintExecutionLog() const {
-  if (!std::filesystem::exists(execute_log_path_)) {
+void CentipedeCallbacks::PrintExecutionLog(const RunnerIo &io) const {
+  if (!std::filesystem::exists(io.execute_log_path)) {
     LOG(WARNING) << "Log file for the last executed binary does not exist: "
-                 << execute_log_path_;
+                 << io.execute_log_path;
     return;
   }
   std::string log_text;
-  ReadFromLocalFile(execute_log_path_, log_text);
+  ReadFromLocalFile(io.execute_log_path, log_text);
   for (const auto &log_line :
        absl::StrSplit(absl::StripAsciiWhitespace(log_text), '\n')) {
     LOG(INFO).NoPrefix() << "LOG: " << log_line;
@@ -17,6 +17,7 @@
 
 #include <cstddef>
 #include <filesystem>  // NOLINT
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -40,7 +41,9 @@ namespace centipede {
 // User must inherit from this class and override at least the
 // pure virtual functions.
 //
-// The classes inherited from this one must be thread-compatible.
+// The classes inherited from this one must be thread-compatible, except that
+// with --pipelined_execution, Execute() and Mutate() may be called
+// concurrently from two threads.
 // Note: the interface is not yet stable and may change w/o a notice.
 class CentipedeCallbacks {
  public:
@@ -49,10 +52,10 @@ class CentipedeCallbacks {
       : env_(env),
         byte_array_mutator_(env.knobs, GetRandomSeed(env.seed)),
         fuzztest_mutator_(env.knobs, GetRandomSeed(env.seed)),
-        inputs_blobseq_(shmem_name1_.c_str(), env.shmem_size_mb << 20,
-                        env.use_posix_shmem),
-        outputs_blobseq_(shmem_name2_.c_str(), env.shmem_size_mb << 20,
-                         env.use_posix_shmem) {
+        execution_io_(env, temp_dir_, /*name=*/"") {
+    if (env.pipelined_execution) {
+      mutation_io_.emplace(env, temp_dir_, /*name=*/"mutation");
+    }
     if (env.use_legacy_default_mutator)
       CHECK(byte_array_mutator_.set_max_len(env.max_len));
     else
@@ -158,29 +161,47 @@ class CentipedeCallbacks {
   FuzzTestMutator fuzztest_mutator_;
 
  private:
-  // Returns a Command object with matching `binary` from commands_,
+  // The shared memory, the output files and the commands for running the
+  // binaries, one run at a time.
+  struct RunnerIo {
+    // `name` tells apart the files and the shared memory of different
+    // instances.
+    RunnerIo(const Environment &env, std::string_view temp_dir,
+             std::string_view name);
+
+    const std::string name;
+    const std::string execute_log_path;
+    const std::string failure_description_path;
+    const std::string shmem_name1;
+    const std::string shmem_name2;
+    SharedMemoryBlobSequence inputs_blobseq;
+    SharedMemoryBlobSequence outputs_blobseq;
+    std::vector<Command> commands;
+  };
+
+  // Returns a Command object with matching `binary` from `io.commands`,
   // creates one if needed.
-  Command &GetOrCreateCommandForBinary(std::string_view binary);
+  Command &GetOrCreateCommandForBinary(std::string_view binary, RunnerIo &io);
 
-  // Prints the execution log from the last executed binary.
-  void PrintExecutionLog() const;
+  // Returns the RunnerIo for mutations via an external binary.
+  RunnerIo &mutation_io() {
+    return mutation_io_.has_value() ? *mutation_io_ : execution_io_;
+  }
+
+  // Prints the execution log from the last binary executed with `io`.
+  void PrintExecutionLog(const RunnerIo &io) const;
 
   // Variables required for ExecuteCentipedeSancovBinaryWithShmem.
   // They are computed in CTOR, to avoid extra computation in the hot loop.
   std::string temp_dir_ = TemporaryLocalDirPath();
   std::string temp_input_file_path_ =
       std::filesystem::path(temp_dir_).append("temp_input_file");
-  const std::string execute_log_path_ =
-      std::filesystem::path(temp_dir_).append("log");
-  std::string failure_description_path_ =
-      std::filesystem::path(temp_dir_).append("failure_description");
-  const std::string shmem_name1_ = ProcessAndThreadUniqueID("/ctpd-shm1-");
-  const std::string shmem_name2_ = ProcessAndThreadUniqueID("/ctpd-shm2-");
-
-  SharedMemoryBlobSequence inputs_blobseq_;
-  SharedMemoryBlobSequence outputs_blobseq_;
 
-  std::vector<Command> commands_;
+  // Executions, and everything else by default, use `execution_io_`. With
+  // --pipelined_execution, mutations use `mutation_io_`, so that a mutation
+  // and an execution, i.e. their runner processes, can run at the same time.
+  RunnerIo execution_io_;
+  std::optional<RunnerIo> mutation_io_;
 };
 
 // Abstract class for creating/destroying CentipedeCallbacks objects.
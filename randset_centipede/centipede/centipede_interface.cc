@@ -58,6 +58,7 @@
 #include "./centipede/periodic_action.h"
 #include "./centipede/runner_result.h"
 #include "./centipede/seed_corpus_maker_lib.h"
+#include "./centipede/shared_coverage_frontier.h"
 #include "./centipede/stats.h"
 #include "./centipede/stop.h"
 #include "./centipede/thread_pool.h"
@@ -196,6 +197,7 @@ int Fuzz(const Environment &env, const BinaryInfo &binary_info,
          std::string_view pcs_file_path,
          CentipedeCallbacksFactory &callbacks_factory) {
   CoverageLogger coverage_logger(binary_info.pc_table, binary_info.symbols);
+  SharedCoverageFrontier coverage_frontier(binary_info);
 
   std::vector<Environment> envs =
       CreateEnvironmentsForThreads(env, pcs_file_path);
@@ -227,8 +229,9 @@ int Fuzz(const Environment &env, const BinaryInfo &binary_info,
   }
 
   auto fuzzing_worker =
-      [&env, &callbacks_factory, &binary_info, &coverage_logger](
-          Environment &my_env, std::atomic<Stats> &stats, bool create_tmpdir) {
+      [&env, &callbacks_factory, &binary_info, &coverage_logger,
+       &coverage_frontier](Environment &my_env, std::atomic<Stats> &stats,
+                           bool create_tmpdir) {
         if (create_tmpdir) CreateLocalDirRemovedAtExit(TemporaryLocalDirPath());
         // Uses TID, call in this thread.
         my_env.seed = GetRandomSeed(env.seed);
@@ -237,7 +240,7 @@ int Fuzz(const Environment &env, const BinaryInfo &binary_info,
 
         ScopedCentipedeCallbacks scoped_callbacks(callbacks_factory, my_env);
         Centipede centipede(my_env, *scoped_callbacks.callbacks(), binary_info,
-                            coverage_logger, stats);
+                            coverage_logger, coverage_frontier, stats);
         centipede.FuzzingLoop();
       };
 
@@ -793,13 +796,20 @@ int CentipedeMain(const Environment &env,
     }
   }
 
-  if (env.distill) return Distill(env);
+  if (env.distill && env.distill_frontier_covers == 0) return Distill(env);
 
   // Create the local temporary dir once, before creating any threads. The
   // temporary dir must typically exist before `CentipedeCallbacks` can be used.
   const auto tmpdir = TemporaryLocalDirPath();
   CreateLocalDirRemovedAtExit(tmpdir);
 
+  if (env.distill) {
+    std::string pcs_file_path;
+    const BinaryInfo binary_info = PopulateBinaryInfoAndSavePCsIfNecessary(
+        env, callbacks_factory, pcs_file_path);
+    return DistillFrontierCovers(env, binary_info);
+  }
+
   // Enter the update corpus database mode only if we have a binary to invoke
   // and a corpus database to update.
   // We don't update the corpus database for standalone binaries (i.e., when
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -20,6 +21,8 @@
 #include <filesystem>  // NOLINT
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <numeric>
 #include <set>
 #include <string>
 #include <string_view>
@@ -34,13 +37,23 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "./centipede/binary_info.h"
+#include "./centipede/centipede.h"
 #include "./centipede/centipede_callbacks.h"
 #include "./centipede/centipede_default_callbacks.h"
 #include "./centipede/centipede_interface.h"
+#include "./centipede/control_flow.h"
+#include "./centipede/corpus.h"
+#include "./centipede/coverage.h"
 #include "./centipede/environment.h"
 #include "./centipede/feature.h"
 #include "./centipede/mutation_input.h"
+#include "./centipede/pc_info.h"
 #include "./centipede/runner_result.h"
+#include "./centipede/shared_coverage_frontier.h"
+#include "./centipede/stats.h"
+#include "./centipede/test_binary_info_util.h"
 #include "./centipede/util.h"
 #include "./centipede/workdir.h"
 #include "./common/defs.h"
@@ -164,6 +177,27 @@ TEST(Centipede, MockTest) {
   EXPECT_EQ(mock.observed_2byte_inputs_.size(), 65536);  // all 2-byte seqs.
 }
 
+TEST(Centipede, MockTestPipelinedExecution) {
+  TempCorpusDir tmp_dir{test_info_->name()};
+  Environment env;
+  env.log_level = 0;  // Disable most of the logging in the test.
+  env.workdir = tmp_dir.path();
+  env.num_runs = 100000;  // Enough to run through all 1- and 2-byte inputs.
+  env.batch_size = 7;     // Just some small number.
+  env.require_pc_table = false;  // No PC table here.
+  env.pipelined_execution = true;
+  CentipedeMock mock(env);
+  MockFactory factory(mock);
+  CentipedeMain(env, factory);  // Run fuzzing with num_runs inputs.
+  // Same as MockTest: the mutants do not depend on the corpus.
+  EXPECT_EQ(mock.num_inputs_, env.num_runs + 1);  // num_runs and one dummy.
+  EXPECT_EQ(mock.num_mutations_, env.num_runs);
+  EXPECT_EQ(mock.max_batch_size_, env.batch_size);
+  EXPECT_EQ(tmp_dir.CountElementsInCorpusFile(0), 512);
+  EXPECT_EQ(mock.observed_1byte_inputs_.size(), 256);    // all 1-byte seqs.
+  EXPECT_EQ(mock.observed_2byte_inputs_.size(), 65536);  // all 2-byte seqs.
+}
+
 static size_t CountFilesInDir(std::string_view dir_path) {
   const std::filesystem::directory_iterator dir_iter{dir_path};
   return std::distance(std::filesystem::begin(dir_iter),
@@ -1020,6 +1054,30 @@ TEST_F(CentipedeWithTemporaryLocalDir, DetectsStackOverflow) {
   EXPECT_EQ(batch_result.failure_description(), "stack-limit-exceeded");
 }
 
+TEST_F(CentipedeWithTemporaryLocalDir,
+       PersistentRunnerServesBatchAfterTruncatedBatch) {
+  Environment env;
+  env.binary = GetDataDependencyFilepath("centipede/testing/test_fuzz_target");
+  env.shmem_size_mb = 1;
+  env.fork_server_persistent_batches = 3;
+  CentipedeDefaultCallbacks callbacks(env);
+  BatchResult batch_result;
+
+  // Only the first input fits in the inputs shared memory, so the runner
+  // sees fewer inputs than announced.
+  const std::vector<ByteArray> truncated_inputs = {ByteArray(600 << 10, 'a'),
+                                                   ByteArray(600 << 10, 'b')};
+  ASSERT_TRUE(callbacks.Execute(env.binary, truncated_inputs, batch_result))
+      << batch_result.log();
+  EXPECT_EQ(batch_result.num_outputs_read(), 1);
+
+  // The same persistent runner serves the next, complete batch.
+  const std::vector<ByteArray> inputs = {{1}, {2}, {3}};
+  ASSERT_TRUE(callbacks.Execute(env.binary, inputs, batch_result))
+      << batch_result.log();
+  EXPECT_EQ(batch_result.num_outputs_read(), inputs.size());
+}
+
 class SetupFailureCallbacks : public CentipedeCallbacks {
  public:
   using CentipedeCallbacks::CentipedeCallbacks;
@@ -1110,5 +1168,207 @@ TEST_F(CentipedeWithTemporaryLocalDir, HangingFuzzTargetExitsAfterTimeout) {
   EXPECT_FALSE(callbacks.Execute(env.binary, {{0}}, batch_result));
 }
 
+}  // namespace
+
+// Calls the seed selection of a Centipede directly, on a corpus of records
+// covering the frontier PCs of diamond functions. Centipede's friend, so it
+// cannot be in the anonymous namespace; the tests use its helpers only.
+class CentipedeSeedSelectionTest : public testing::Test {
+ protected:
+  static constexpr size_t kNumFunctions = 16;
+
+  CentipedeSeedSelectionTest() {
+    env_.log_level = 0;
+    env_.seed = 1;
+  }
+
+  // Creates the Centipede under test. Call after setting up `env_`.
+  void CreateCentipede() {
+    callbacks_ = std::make_unique<CentipedeMock>(env_);
+    centipede_ = std::make_unique<Centipede>(
+        env_, *callbacks_, bin_info_, coverage_logger_, frontier_, stats_);
+  }
+
+  // Adds a corpus record covering bbs 0 and 1 of every function in
+  // `functions`. Both are frontier PCs, as bbs 2 and 3 stay uncovered.
+  void AddRecord(const std::vector<size_t> &functions) {
+    FeatureVec fv;
+    for (const size_t f : functions) {
+      fv.push_back(feature_domains::kPCs.ConvertToMe(4 * f));
+      fv.push_back(feature_domains::kPCs.ConvertToMe(4 * f + 1));
+    }
+    centipede_->fs_.IncrementFrequencies(fv);
+    frontier_.AddCoverage(fv);
+    frontier_.Read([&](const CoverageFrontier &frontier) {
+      centipede_->corpus_.Add({1}, fv, {}, centipede_->fs_, frontier);
+    });
+  }
+
+  // Returns the selection weight of the frontier PCs of record `index`.
+  uint64_t SelectionWeight(size_t index) const {
+    uint64_t weight = 0;
+    frontier_.Read([&](const CoverageFrontier &frontier) {
+      for (const PCIndex pc_index :
+           centipede_->corpus_.GetFrontierNodeSet(index)) {
+        weight += Centipede::FrontierSelectionWeight(frontier, pc_index);
+      }
+    });
+    return weight;
+  }
+
+  // Runs one FirstMoverSelection() batch over all records.
+  std::vector<size_t> Select(size_t num_seeds) {
+    std::vector<size_t> all_records(centipede_->corpus_.NumActive());
+    std::iota(all_records.begin(), all_records.end(), 0);
+    const absl::Span<const size_t> selected =
+        centipede_->FirstMoverSelection(all_records, num_seeds);
+    return {selected.begin(), selected.end()};
+  }
+
+  // Forgets all selections made so far.
+  void ResetSelections() {
+    frontier_.ResetSelections(frontier_.BeginSelectionBatch());
+  }
+
+  // Returns the number of records the last batch could pick from for their
+  // frontier PCs not selected recently.
+  size_t NumFirstMoverCandidates() const {
+    return centipede_->first_mover_candidates_.size();
+  }
+
+  // Returns true iff all frontier PCs of record `index` counted as selected
+  // recently in the last batch.
+  bool SelectedRecently(size_t index) const {
+    const PCIndexVec &pcs = centipede_->corpus_.GetFrontierNodeSet(index);
+    return !pcs.empty() &&
+           std::all_of(pcs.begin(), pcs.end(), [&](PCIndex pc_index) {
+             return centipede_->FrontierPcSelectedRecently(pc_index);
+           });
+  }
+
+  Environment env_;
+  const BinaryInfo bin_info_ = DiamondFunctions(kNumFunctions);
+  CoverageLogger coverage_logger_{bin_info_.pc_table, bin_info_.symbols};
+  SharedCoverageFrontier frontier_{bin_info_};
+  std::atomic<Stats> stats_;
+  std::unique_ptr<CentipedeMock> callbacks_;
+  std::unique_ptr<Centipede> centipede_;
+};
+
+namespace {
+
+TEST_F(CentipedeSeedSelectionTest, WeightedFirstMoverSelectionPicksDistinct) {
+  env_.weighted_first_mover_selection = true;
+  CreateCentipede();
+  AddRecord({0});
+  AddRecord({1, 2});
+  AddRecord({3, 4, 5});
+  // Shares function 0 with record 0: once either is picked, record 3 has only
+  // function 6 left, and record 0 nothing.
+  AddRecord({0, 6});
+
+  for (size_t i = 0; i < 100; ++i) {
+    const std::vector<size_t> selected = Select(/*num_seeds=*/10);
+    EXPECT_TRUE(std::adjacent_find(selected.begin(), selected.end()) ==
+                selected.end());
+    EXPECT_THAT(selected, IsSupersetOf({1, 2, 3}));
+    EXPECT_LE(selected.size(), 4);
+    ResetSelections();
+  }
+}
+
+TEST_F(CentipedeSeedSelectionTest, WeightedFirstMoverSelectionFollowsWeights) {
+  env_.weighted_first_mover_selection = true;
+  CreateCentipede();
+  AddRecord({0});
+  AddRecord({1, 2});
+  AddRecord({3, 4, 5});
+  const std::vector<uint64_t> weights = {SelectionWeight(0), SelectionWeight(1),
+                                         SelectionWeight(2)};
+  ASSERT_LT(weights[0], weights[1]);
+  ASSERT_LT(weights[1], weights[2]);
+  const uint64_t total_weight = weights[0] + weights[1] + weights[2];
+
+  constexpr size_t kNumTrials = 6000;
+  std::vector<size_t> freq(weights.size());
+  for (size_t i = 0; i < kNumTrials; ++i) {
+    const std::vector<size_t> selected = Select(/*num_seeds=*/1);
+    ASSERT_EQ(selected.size(), 1);
+    ++freq[selected[0]];
+    ResetSelections();
+  }
+  for (size_t i = 0; i < weights.size(); ++i) {
+    EXPECT_NEAR(freq[i], kNumTrials * weights[i] / total_weight,
+                kNumTrials / 20)
+        << i;
+  }
+}
+
+TEST_F(CentipedeSeedSelectionTest, FrontierPcIsEligibleAgainAfterWindow) {
+  env_.frontier_selection_window = 1;
+  env_.reset_frontier_selection_when_exhausted = false;
+  CreateCentipede();
+  AddRecord({0});
+  AddRecord({1});
+
+  const std::vector<size_t> first = Select(/*num_seeds=*/1);
+  ASSERT_EQ(first.size(), 1);
+  EXPECT_EQ(NumFirstMoverCandidates(), 2);
+  // The first pick is still within the window: the other record is next.
+  const std::vector<size_t> second = Select(/*num_seeds=*/1);
+  ASSERT_EQ(second.size(), 1);
+  EXPECT_NE(second, first);
+  EXPECT_EQ(NumFirstMoverCandidates(), 1);
+  EXPECT_TRUE(SelectedRecently(first[0]));
+  // Now only the second pick is: the first one is eligible again.
+  EXPECT_EQ(Select(/*num_seeds=*/1), first);
+  EXPECT_EQ(NumFirstMoverCandidates(), 1);
+}
+
+TEST_F(CentipedeSeedSelectionTest, FrontierSelectionWindowZeroMeansEver) {
+  env_.frontier_selection_window = 0;
+  env_.reset_frontier_selection_when_exhausted = false;
+  CreateCentipede();
+  AddRecord({0});
+  AddRecord({1});
+
+  const std::vector<size_t> first = Select(/*num_seeds=*/1);
+  const std::vector<size_t> second = Select(/*num_seeds=*/1);
+  ASSERT_EQ(first.size(), 1);
+  ASSERT_EQ(second.size(), 1);
+  EXPECT_NE(second, first);
+
+  // Many batches later, both records were still selected recently. With no
+  // candidates left, the selection falls back to the whole reduced set.
+  for (size_t i = 0; i < 100; ++i) Select(/*num_seeds=*/1);
+  EXPECT_EQ(NumFirstMoverCandidates(), 0);
+  EXPECT_TRUE(SelectedRecently(0));
+  EXPECT_TRUE(SelectedRecently(1));
+  EXPECT_EQ(Select(/*num_seeds=*/1).size(), 1);
+}
+
+TEST_F(CentipedeSeedSelectionTest, FrontierSelectionResetsWhenExhausted) {
+  env_.frontier_selection_window = 0;
+  env_.reset_frontier_selection_when_exhausted = true;
+  CreateCentipede();
+  AddRecord({0});
+  AddRecord({1});
+
+  const std::vector<size_t> first = Select(/*num_seeds=*/1);
+  const std::vector<size_t> second = Select(/*num_seeds=*/1);
+  ASSERT_EQ(first.size(), 1);
+  ASSERT_EQ(second.size(), 1);
+  EXPECT_NE(second, first);
+  EXPECT_EQ(NumFirstMoverCandidates(), 1);
+
+  // Every frontier PC was selected: the next batch starts a new round, with
+  // both records as candidates, and forgets the earlier selections.
+  const std::vector<size_t> third = Select(/*num_seeds=*/1);
+  ASSERT_EQ(third.size(), 1);
+  EXPECT_EQ(NumFirstMoverCandidates(), 2);
+  EXPECT_TRUE(SelectedRecently(third[0]));
+  EXPECT_FALSE(SelectedRecently(1 - third[0]));
+}
+
 }  // namespace
 }  // namespace centipede
@@ -15,10 +15,9 @@
 #include "./centipede/command.h"
 
 #include <errno.h>
-#include <fcntl.h>
-#include <sys/poll.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #ifdef __APPLE__
 #include <inttypes.h>
@@ -26,10 +25,13 @@
 #endif  // __APPLE__
 
 #include <algorithm>
+#include <atomic>
 #include <csignal>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>  // NOLINT
 #include <fstream>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <system_error>  // NOLINT
@@ -51,6 +53,8 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "./centipede/fork_server_channel.h"
+#include "./centipede/shared_memory_blob_sequence.h"
 #include "./centipede/stop.h"
 #include "./centipede/util.h"
 #include "./common/logging.h"
@@ -108,14 +112,14 @@ absl::StatusOr<std::string> GetProcessCreationStamp(pid_t pid) {
 // TODO(ussuri): Encapsulate as much of the fork server functionality from
 //  this source as possible in this struct, and make it a class.
 struct Command::ForkServerProps {
-  // The file paths of the comms pipes.
-  std::string fifo_path_[2];
-  // The file descriptors of the comms pipes.
-  int pipe_[2] = {-1, -1};
+  // The shared memory holding the command channel.
+  std::unique_ptr<SharedMemoryBlobSequence> channel_blobseq_;
+  // The command channel, in `channel_blobseq_`.
+  ForkServerChannel *channel_ = nullptr;
   // The file path to write the PID of the fork server process to.
   std::string pid_file_path_;
   // The PID of the fork server process. Used to verify that the fork server is
-  // running and the pipes are ready for comms.
+  // running and the channel is ready for comms.
   pid_t pid_ = -1;
   // The creation stamp of the fork server process. Used to detect that the
   // running process with `pid_` is still the original fork server, not a PID
@@ -123,16 +127,10 @@ struct Command::ForkServerProps {
   std::string creation_stamp;
 
   ~ForkServerProps() {
-    for (int i = 0; i < 2; ++i) {
-      if (pipe_[i] >= 0 && close(pipe_[i]) != 0) {
-        LOG(ERROR) << "Failed to close fork server pipe for " << fifo_path_[i];
-      }
-      std::error_code ec;
-      if (!fifo_path_[i].empty() &&
-          !std::filesystem::remove(fifo_path_[i], ec)) {
-        LOG(ERROR) << "Failed to remove fork server pipe file " << fifo_path_[i]
-                   << ": " << ec;
-      }
+    // The fork server, or its persistent child, exits once it sees this.
+    if (channel_ != nullptr) {
+      ForkServerChannelPost(channel_->shutdown, 1);
+      ForkServerChannelWake(channel_->request);
     }
   }
 };
@@ -204,17 +202,21 @@ bool Command::StartForkServer(std::string_view temp_dir_path,
   VLOG(2) << "Starting fork server for " << path();
 
   fork_server_.reset(new ForkServerProps);
-  fork_server_->fifo_path_[0] = std::filesystem::path(temp_dir_path)
-                                    .append(absl::StrCat(prefix, "_FIFO0"));
-  fork_server_->fifo_path_[1] = std::filesystem::path(temp_dir_path)
-                                    .append(absl::StrCat(prefix, "_FIFO1"));
-  const std::string pid_file_path =
-      std::filesystem::path(temp_dir_path).append("pid");
+  // POSIX shared memory names are global, and short on some platforms: make
+  // them unique to the process and to the command.
+  static std::atomic<size_t> channel_counter = 0;
+  const std::string channel_name =
+      absl::StrCat("/centipede-fs-", getpid(), "-", channel_counter++);
+  fork_server_->channel_blobseq_ = std::make_unique<SharedMemoryBlobSequence>(
+      channel_name.c_str(), /*size=*/1024, /*use_posix_shmem=*/true);
+  fork_server_->channel_ =
+      CreateForkServerChannel(*fork_server_->channel_blobseq_);
+  CHECK(fork_server_->channel_ != nullptr) << VV(channel_name);
+  fork_server_->channel_->engine_pid = getpid();
+  fork_server_->channel_->persistent_batches = options_.persistent_batches;
+  const std::string pid_file_path = std::filesystem::path(temp_dir_path)
+                                        .append(absl::StrCat(prefix, "_PID"));
   (void)std::filesystem::create_directory(temp_dir_path);  // it may not exist.
-  for (int i = 0; i < 2; ++i) {
-    PCHECK(mkfifo(fork_server_->fifo_path_[i].c_str(), 0600) == 0)
-        << VV(i) << VV(fork_server_->fifo_path_[i]);
-  }
 
   // NOTE: A background process does not return its exit status to the subshell,
   // so failures will never propagate to the caller of `system()`. Instead, we
@@ -222,15 +224,14 @@ bool Command::StartForkServer(std::string_view temp_dir_path,
   // that the process has started and is still running.
   static constexpr std::string_view kForkServerCommandStub = R"sh(
   {
-    CENTIPEDE_FORK_SERVER_FIFO0="%s" \
-    CENTIPEDE_FORK_SERVER_FIFO1="%s" \
+    CENTIPEDE_FORK_SERVER_CHANNEL="%s" \
     %s
   } &
   printf "%%s" $! > "%s"
 )sh";
   const std::string fork_server_command = absl::StrFormat(
-      kForkServerCommandStub, fork_server_->fifo_path_[0],
-      fork_server_->fifo_path_[1], command_line_, pid_file_path);
+      kForkServerCommandStub, fork_server_->channel_blobseq_->path(),
+      command_line_, pid_file_path);
   VLOG(2) << "Fork server command:" << fork_server_command;
 
   const int exit_code = system(fork_server_command.c_str());
@@ -244,27 +245,8 @@ bool Command::StartForkServer(std::string_view temp_dir_path,
   }
 
   // The fork server is probably running now. However, one failure scenario is
-  // that it starts and exits early. Try opening the read/write comms pipes with
-  // it: if that fails, something is wrong.
-  // We use non-blocking I/O to open the pipes. That is good and safe, because:
-  // 1) This prevents the `open()` calls from hanging when the fork server fails
-  // to open the pipes on its side (note the use of O_RDWR, not O_WRONLY, to
-  // avoid ENXIO).
-  // 2) In `Command::Execute`, we wait for the return channel pipe with a
-  // `poll()`, so it should always have data when we attempt to `read()` from
-  // it.
-  // See more at
-  // https://www.gnu.org/software/libc/manual/html_node/Operating-Modes.html.
-  if ((fork_server_->pipe_[0] = open(fork_server_->fifo_path_[0].c_str(),
-                                     O_RDWR | O_NONBLOCK)) < 0 ||
-      (fork_server_->pipe_[1] = open(fork_server_->fifo_path_[1].c_str(),
-                                     O_RDONLY | O_NONBLOCK)) < 0) {
-    LogProblemInfo(
-        "Failed to establish communication with fork server; will proceed "
-        "without it");
-    return false;
-  }
-
+  // that it starts and exits early: `Command::Execute` checks that the fork
+  // server process is alive while waiting for its responses.
   std::string pid_str;
   ReadFromLocalFile(pid_file_path, pid_str);
   CHECK(absl::SimpleAtoi(pid_str, &fork_server_->pid_)) << VV(pid_str);
@@ -284,10 +266,10 @@ bool Command::StartForkServer(std::string_view temp_dir_path,
 absl::Status Command::VerifyForkServerIsHealthy() {
   // Preconditions: the callers (`Execute()`) should call us only when the fork
   // server is presumed to be running (`fork_server_pid_` >= 0). If it is, the
-  // comms pipes are guaranteed to be opened by `StartForkServer()`.
+  // command channel is guaranteed to be created by `StartForkServer()`.
   CHECK(fork_server_ != nullptr) << "Fork server wasn't started";
   CHECK(fork_server_->pid_ >= 0) << "Fork server process failed to start";
-  CHECK(fork_server_->pipe_[0] >= 0 && fork_server_->pipe_[1] >= 0)
+  CHECK(fork_server_->channel_ != nullptr)
       << "Failed to connect to fork server";
 
   // A process with the fork server PID exists (_some_ process, possibly with a
@@ -324,45 +306,42 @@ int Command::Execute() {
     }
 
     // Wake up the fork server.
-    char x = ' ';
-    CHECK_EQ(1, write(fork_server_->pipe_[0], &x, 1));
-
-    // The fork server forks, the child is running. Block until some readable
-    // data appears in the pipe (that is, after the fork server writes the
-    // execution result to it).
-    struct pollfd poll_fd = {};
-    int poll_ret = -1;
-    auto poll_deadline = absl::Now() + options_.timeout;
-    // The `poll()` syscall can get interrupted: it sets errno==EINTR in that
-    // case. We should tolerate that.
-    do {
-      // NOTE: `poll_fd` has to be reset every time.
-      poll_fd = {
-          /*fd=*/fork_server_->pipe_[1],  // The file descriptor to wait for.
-          /*events=*/POLLIN,              // Wait until `fd` gets readable data.
-      };
-      const int poll_timeout_ms = static_cast<int>(absl::ToInt64Milliseconds(
-          std::max(poll_deadline - absl::Now(), absl::Milliseconds(1))));
-      poll_ret = poll(&poll_fd, 1, poll_timeout_ms);
-    } while (poll_ret < 0 && errno == EINTR);
-
-    if (poll_ret != 1 || (poll_fd.revents & POLLIN) == 0) {
-      // The fork server errored out or timed out, or some other error occurred,
-      // e.g. the syscall was interrupted.
-      if (poll_ret == 0) {
+    ForkServerChannel &channel = *fork_server_->channel_;
+    const uint32_t request =
+        channel.request.fetch_add(1, std::memory_order_acq_rel) + 1;
+    ForkServerChannelWake(channel.request);
+
+    // The fork server forks, the child is running. Sleep until the response
+    // to `request` appears in the channel, checking now and then that the
+    // fork server is still there to respond.
+    constexpr absl::Duration kHealthCheckInterval = absl::Seconds(1);
+    const auto deadline = absl::Now() + options_.timeout;
+    while (true) {
+      const uint32_t response =
+          channel.response.load(std::memory_order_acquire);
+      if (response == request) break;
+      const auto now = absl::Now();
+      if (now >= deadline) {
         LogProblemInfo(
             absl::StrCat("Timeout while waiting for fork server: timeout is ",
                          absl::FormatDuration(options_.timeout)));
-      } else {
-        LogProblemInfo(absl::StrCat(
-            "Error while waiting for fork server: poll() returned ", poll_ret));
+        return EXIT_FAILURE;
+      }
+      const int wait_timeout_ms = static_cast<int>(absl::ToInt64Milliseconds(
+          std::clamp(deadline - now, absl::Milliseconds(1),
+                     kHealthCheckInterval)));
+      ForkServerChannelWait(channel.response, response, wait_timeout_ms);
+      if (channel.response.load(std::memory_order_acquire) != request) {
+        if (const auto status = VerifyForkServerIsHealthy(); !status.ok()) {
+          LogProblemInfo(absl::StrCat(
+              "Error while waiting for fork server: ", status.message()));
+          return EXIT_FAILURE;
+        }
       }
-      return EXIT_FAILURE;
     }
 
-    // The fork server wrote the execution result to the pipe: read it.
-    CHECK_EQ(sizeof(exit_code),
-             read(fork_server_->pipe_[1], &exit_code, sizeof(exit_code)));
+    // The fork server wrote the execution result to the channel: read it.
+    exit_code = channel.status;
   } else {
     VLOG(1) << "Fork server disabled - executing command directly";
     // No fork server, use system().
@@ -15,6 +15,7 @@
 #ifndef THIRD_PARTY_CENTIPEDE_COMMAND_H_
 #define THIRD_PARTY_CENTIPEDE_COMMAND_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -45,6 +46,10 @@ class Command final {
     std::string stderr_file;
     // Terminate a fork server execution attempt after this duration.
     absl::Duration timeout = absl::InfiniteDuration();
+    // Allow a runner forked by the fork server to handle up to this many
+    // execution requests before exiting (see runner_fork_server.cc). 0 or 1
+    // means a fresh fork for every execution.
+    size_t persistent_batches = 0;
     // "@@" in the command will be replaced with `temp_file_path`.
     std::string temp_file_path;
   };
@@ -75,8 +80,9 @@ class Command final {
   int Execute();
 
   // Attempts to start a fork server, returns true on success.
-  // Pipe files for the fork server are created in `temp_dir_path`
-  // with prefix `prefix`.
+  // The PID file of the fork server is created in `temp_dir_path`
+  // with prefix `prefix`. The fork server gets its command channel via
+  // shared memory.
   // See runner_fork_server.cc for details.
   bool StartForkServer(std::string_view temp_dir_path, std::string_view prefix);
 
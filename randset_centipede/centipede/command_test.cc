@@ -199,5 +199,28 @@ TEST(CommandTest, ForkServer) {
   // TODO(kcc): [impl] test what happens if the child is interrupted.
 }
 
+TEST(CommandTest, ForkServerPersistentMode) {
+  const std::string test_tmpdir = GetTestTempDir(test_info_->name());
+  const std::string helper =
+      GetDataDependencyFilepath("centipede/command_test_helper");
+  const std::string input = "persistent";
+  const std::string log = std::filesystem::path{test_tmpdir} / input;
+  Command::Options cmd_options;
+  cmd_options.args = {input};
+  cmd_options.stdout_file = log;
+  cmd_options.stderr_file = log;
+  cmd_options.persistent_batches = 3;
+  Command cmd{helper, std::move(cmd_options)};
+  ASSERT_TRUE(cmd.StartForkServer(test_tmpdir, "ForkServer"));
+  // Every third execution gets a fresh fork.
+  for (int batch : {0, 1, 2, 0, 1}) {
+    EXPECT_EQ(cmd.Execute(), EXIT_SUCCESS);
+    std::string log_contents;
+    ReadFromLocalFile(log, log_contents);
+    EXPECT_EQ(log_contents, absl::Substitute("Got input: $0, batch $1", input,
+                                             batch));
+  }
+}
+
 }  // namespace
 }  // namespace centipede
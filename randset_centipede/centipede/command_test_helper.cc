@@ -21,9 +21,23 @@
 
 #include "absl/base/nullability.h"
 
+namespace centipede {
+// Defined in runner_fork_server.cc.
+extern bool ForkServerServeNextRequest(int status);
+}  // namespace centipede
+
 // A binary linked with the fork server that exits/crashes in different ways.
 int main(int argc, absl::Nonnull<char **> argv) {
   assert(argc == 2);
+  if (!strcmp(argv[1], "persistent")) {
+    // Serves as many requests as the fork server allows, in this process.
+    int batch = 0;
+    do {
+      printf("Got input: %s, batch %d", argv[1], batch++);
+      fflush(stdout);
+    } while (centipede::ForkServerServeNextRequest(EXIT_SUCCESS));
+    return EXIT_SUCCESS;
+  }
   printf("Got input: %s", argv[1]);
   fflush(stdout);
   if (!strcmp(argv[1], "success")) return EXIT_SUCCESS;
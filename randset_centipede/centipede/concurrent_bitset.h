@@ -42,6 +42,7 @@
 
 #include "absl/base/const_init.h"
 #include "./centipede/concurrent_byteset.h"
+#include "./centipede/foreach_nonzero.h"
 
 namespace centipede {
 
@@ -99,8 +100,8 @@ class ConcurrentBitSet {
 
   // Calls `action(index)` for every index of a non-zero bit in the set,
   // then sets all those bits to zero.
-  __attribute__((noinline)) void ForEachNonZeroBit(
-      const std::function<void(size_t idx)> &action) {
+  template <typename Action>
+  __attribute__((noinline)) void ForEachNonZeroBit(const Action &action) {
     // Iterates over all non-empty lines.
     lines_.ForEachNonZeroByte([&](size_t idx, uint8_t value) {
       size_t word_idx_beg = idx * kWordsInLine;
@@ -110,18 +111,28 @@ class ConcurrentBitSet {
   }
 
  private:
-  // Iterates over the range of words [`word_idx_beg`, `word_idx_end`).
-  void ForEachNonZeroBit(const std::function<void(size_t idx)> &action,
-                         size_t word_idx_beg, size_t word_idx_end) {
-    for (size_t word_idx = word_idx_beg; word_idx < word_idx_end; ++word_idx) {
-      if (word_t word = words_[word_idx]) {
-        words_[word_idx] = 0;
-        do {
-          size_t bit_idx = __builtin_ctzll(word);
-          action(word_idx * kBitsInWord + bit_idx);
-          word_t mask = 1ULL << bit_idx;
-          word &= ~mask;
-        } while (word);
+  // Iterates over the range of words [`word_idx_beg`, `word_idx_end`),
+  // skipping the blocks of zero words.
+  template <typename Action>
+  void ForEachNonZeroBit(const Action &action, size_t word_idx_beg,
+                         size_t word_idx_end) {
+    for (size_t block_idx = word_idx_beg; block_idx < word_idx_end;
+         block_idx += kWordsInScanBlock) {
+      if (!NonZeroByteMask(
+              reinterpret_cast<const uint8_t *>(&words_[block_idx]))) {
+        continue;
+      }
+      for (size_t word_idx = block_idx;
+           word_idx < block_idx + kWordsInScanBlock; ++word_idx) {
+        if (word_t word = words_[word_idx]) {
+          words_[word_idx] = 0;
+          do {
+            size_t bit_idx = __builtin_ctzll(word);
+            action(word_idx * kBitsInWord + bit_idx);
+            word_t mask = 1ULL << bit_idx;
+            word &= ~mask;
+          } while (word);
+        }
       }
     }
   }
@@ -138,11 +149,15 @@ class ConcurrentBitSet {
   static constexpr size_t kBytesInLine = 64 * 8;
   static constexpr size_t kWordsInLine = kBytesInLine / kBytesInWord;
   static constexpr size_t kSizeInLines = kSizeInWords / kWordsInLine;
+  // Lines are scanned by blocks of this many words, see NonZeroByteMask().
+  static constexpr size_t kWordsInScanBlock =
+      kNonZeroScanBlockSize / kBytesInWord;
+  static_assert((kBytesInLine % kNonZeroScanBlockSize) == 0);
   ConcurrentByteSet<kSizeInLines> lines_;
   // NOTE: No initializer for performance (`kSizeInWords` can be quite large).
   // Relies on static initialization in the process image (see the class
   // comment).
-  word_t words_[kSizeInWords];
+  word_t words_[kSizeInWords] __attribute__((aligned(64)));
 };
 
 }  // namespace centipede
@@ -33,10 +33,10 @@
 // include it into runner.
 
 #include "absl/base/const_init.h"
+#include "./centipede/foreach_nonzero.h"
 
 namespace centipede {
 
-// TODO(kcc): replace the standalone ForEachNonZeroByte with code from here.
 // TODO(kcc): ConcurrentByteSet is an unoptimized single-layer byte set.
 // Implement multi-layer byte set(s).
 
@@ -82,25 +82,16 @@ class ConcurrentByteSet {
   // the set, then sets all those bytes to zero.
   // `from` and `to` set the range of elements to iterate, both must be
   // multiples of kSizeMultiple.
-  void ForEachNonZeroByte(const std::function<void(size_t, uint8_t)> &action,
-                          size_t from = 0, size_t to = kSize) {
-    using word_t = uintptr_t;
-    constexpr size_t kWordSize = sizeof(word_t);
+  template <typename Action>
+  void ForEachNonZeroByte(const Action &action, size_t from = 0,
+                          size_t to = kSize) {
+    static_assert((kSizeMultiple % kNonZeroScanBlockSize) == 0);
     if (from % kSizeMultiple) __builtin_trap();
     if (to % kSizeMultiple) __builtin_trap();
     if (to > kSize) __builtin_trap();
-    // Iterate one word at a time.
-    for (uint8_t *ptr = &bytes_[from], *end = &bytes_[to]; ptr < end;
-         ptr += kWordSize) {
-      word_t word;
-      __builtin_memcpy(&word, ptr, kWordSize);
-      if (!word) continue;
-      __builtin_memset(ptr, 0, kWordSize);
-      // This loop assumes little-endianness. (Tests will break on big-endian).
-      for (size_t pos = 0; pos < kWordSize; pos++) {
-        uint8_t value = word >> (pos * CHAR_BIT);  // lowest byte is taken.
-        if (value) action(ptr - &bytes_[0] + pos, value);
-      }
+    // Iterate one block at a time.
+    for (size_t idx = from; idx < to; idx += kNonZeroScanBlockSize) {
+      ForEachNonZeroByteInBlock(&bytes_[idx], idx, action);
     }
   }
 
@@ -147,8 +138,9 @@ class LayeredConcurrentByteSet {
     lower_layer_.SaturatedIncrement(idx);
   }
 
-  void ForEachNonZeroByte(const std::function<void(size_t, uint8_t)> &action,
-                          size_t from = 0, size_t to = kSize) {
+  template <typename Action>
+  void ForEachNonZeroByte(const Action &action, size_t from = 0,
+                          size_t to = kSize) {
     if (to > kSize) __builtin_trap();
     if (from % kSizeMultiple) __builtin_trap();
     if (to % kSizeMultiple) __builtin_trap();
@@ -27,11 +27,14 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "./centipede/control_flow.h"
 #include "./centipede/coverage.h"
 #include "./centipede/execution_metadata.h"
 #include "./centipede/feature.h"
+#include "./centipede/feature_compression.h"
 #include "./centipede/feature_set.h"
+#include "./centipede/thread_pool.h"
 #include "./centipede/util.h"
 #include "./common/defs.h"
 #include "./common/logging.h"  // IWYU pragma: keep
@@ -45,7 +48,8 @@ namespace centipede {
 //------------------------------------------------------------------------------
 
 // Returns the weight of `fv` computed using `fs` and `coverage_frontier`.
-static size_t ComputeWeight(const FeatureVec &fv, const FeatureSet &fs,
+static size_t ComputeWeight(absl::Span<const feature_t> fv,
+                            const FeatureSet &fs,
                             const CoverageFrontier &coverage_frontier) {
   size_t weight = fs.ComputeWeight(fv);
   // The following is checking for the cases where PCTable is not present. In
@@ -65,45 +69,143 @@ static size_t ComputeWeight(const FeatureVec &fv, const FeatureSet &fs,
   return weight * (frontier_weights_sum + 1);  // Multiply by at least 1.
 }
 
+absl::Span<const feature_t> Corpus::GetFeatures(size_t idx,
+                                                FeatureVec &scratch) const {
+  const FeatureRange &range = feature_ranges_[idx];
+  if (compress_features_) {
+    DecompressFeatures(
+        absl::MakeConstSpan(compressed_features_).subspan(range.begin,
+                                                          range.size),
+        scratch);
+    return scratch;
+  }
+  return absl::MakeConstSpan(features_).subspan(range.begin, range.size);
+}
+
+template <typename Callback>
+void Corpus::ForEachFeature(size_t idx, Callback callback) const {
+  const FeatureRange &range = feature_ranges_[idx];
+  if (compress_features_) {
+    ForEachCompressedFeature(
+        absl::MakeConstSpan(compressed_features_).subspan(range.begin,
+                                                          range.size),
+        callback);
+    return;
+  }
+  for (size_t i = range.begin; i < range.begin + range.size; ++i) {
+    callback(features_[i]);
+  }
+}
+
+void Corpus::AddToFrontierIndex(const CoverageFrontier &coverage_frontier,
+                                size_t idx) {
+  PCIndexVec &frontier_node_set = frontier_node_sets_[idx];
+  frontier_node_set.clear();
+  ForEachFeature(idx, [&](feature_t feature) {
+    if (!feature_domains::kPCs.Contains(feature)) return;
+    size_t pc_index = ConvertPCFeatureToPcIndex(feature);
+    if (pc_index >= records_by_pc_.size()) return;
+    records_by_pc_[pc_index].push_back(idx);
+    if (coverage_frontier.PcIndexIsGlobalFrontier(pc_index)) {
+      frontier_node_set.push_back(pc_index);
+    }
+  });
+  std::sort(frontier_node_set.begin(), frontier_node_set.end());
+  frontier_node_set.erase(
+      std::unique(frontier_node_set.begin(), frontier_node_set.end()),
+      frontier_node_set.end());
+}
+
 std::pair<size_t, size_t> Corpus::MaxAndAvgSize() const {
-  if (records_.empty()) return {0, 0};
+  if (data_.empty()) return {0, 0};
   size_t max = 0;
   size_t total = 0;
-  for (const auto &r : records_) {
-    max = std::max(max, r.data.size());
-    total += r.data.size();
+  for (const auto &data : data_) {
+    max = std::max(max, data.size());
+    total += data.size();
   }
-  return {max, total / records_.size()};
+  return {max, total / data_.size()};
+}
+
+const std::vector<uint32_t> &Corpus::RecordsWithPc(PCIndex pc_index) const {
+  static const std::vector<uint32_t> *const kNoRecords =
+      new std::vector<uint32_t>();
+  if (pc_index >= records_by_pc_.size()) return *kNoRecords;
+  return records_by_pc_[pc_index];
 }
 
+void Corpus::UpdateFrontierNodeSetForCorpus(
+    const CoverageFrontier &coverage_frontier) {
+  if (coverage_frontier.GlobalFrontierWasReset()) {
+    RebuildFrontierIndex(coverage_frontier);
+    return;
+  }
+  UpdateFrontierNodeSetForCorpus(coverage_frontier,
+                                 coverage_frontier.GlobalFrontierChanges());
+}
 
-void Corpus::UpdateFrontierNodeSetForCorpus(const CoverageFrontier &coverage_frontier) {
-  for (auto &record : records_) {
-    record.frontier_node_set.clear();
-    // printf("================================================");
-    for (const auto feature : record.features) {
-      if (!feature_domains::kPCs.Contains(feature)) continue;
-      size_t pc_index = ConvertPCFeatureToPcIndex(feature);
-      // printf("pc_index  %d\n", pc_index);
-      if (pc_index < coverage_frontier.MaxPcIndex() && coverage_frontier.PcIndexIsFrontier(pc_index)) {
-        record.frontier_node_set.insert(pc_index);
+void Corpus::UpdateFrontierNodeSetForCorpus(
+    const CoverageFrontier &coverage_frontier,
+    absl::Span<const PCIndex> changed_pcs) {
+  for (const PCIndex pc_index : changed_pcs) {
+    if (pc_index >= records_by_pc_.size()) continue;
+    const bool is_frontier = coverage_frontier.PcIndexIsGlobalFrontier(pc_index);
+    for (const uint32_t record_index : records_by_pc_[pc_index]) {
+      auto &frontier_node_set = frontier_node_sets_[record_index];
+      auto it = std::lower_bound(frontier_node_set.begin(),
+                                 frontier_node_set.end(), pc_index);
+      const bool present = it != frontier_node_set.end() && *it == pc_index;
+      if (is_frontier && !present) {
+        frontier_node_set.insert(it, pc_index);
+      } else if (!is_frontier && present) {
+        frontier_node_set.erase(it);
       }
     }
   }
 }
 
+void Corpus::RebuildFrontierIndex(const CoverageFrontier &coverage_frontier) {
+  for (auto &records : records_by_pc_) {
+    records.clear();
+  }
+  records_by_pc_.resize(coverage_frontier.MaxPcIndex());
+  for (size_t i = 0, n = NumActive(); i < n; ++i) {
+    AddToFrontierIndex(coverage_frontier, i);
+  }
+}
+
 size_t Corpus::Prune(const FeatureSet &fs,
                      const CoverageFrontier &coverage_frontier,
                      size_t max_corpus_size, Rng &rng) {
   // TODO(kcc): use coverage_frontier.
   CHECK(max_corpus_size);
-  if (records_.size() < 2UL) return 0;
-  // Recompute the weights.
+  if (NumActive() < 2UL) return 0;
+  // Recompute the weights. Pruning only shrinks the features of a record, so
+  // they stay where they are. Compressed, the remaining deltas are sums of the
+  // old ones and take at most as many bytes.
   size_t num_zero_weights = 0;
-  for (size_t i = 0, n = records_.size(); i < n; ++i) {
-    fs.PruneFeaturesAndCountUnseen(records_[i].features);
-    auto new_weight =
-        ComputeWeight(records_[i].features, fs, coverage_frontier);
+  FeatureVec pruned_features;
+  ByteArray recompressed_features;
+  for (size_t i = 0, n = NumActive(); i < n; ++i) {
+    FeatureRange &range = feature_ranges_[i];
+    pruned_features.clear();
+    ForEachFeature(i, [&](feature_t feature) {
+      pruned_features.push_back(feature);
+    });
+    fs.PruneFeaturesAndCountUnseen(pruned_features);
+    if (compress_features_) {
+      recompressed_features.clear();
+      CompressSortedFeatures(pruned_features, recompressed_features);
+      CHECK_LE(recompressed_features.size(), range.size);
+      std::copy(recompressed_features.begin(), recompressed_features.end(),
+                compressed_features_.begin() + range.begin);
+      range.size = recompressed_features.size();
+    } else {
+      std::copy(pruned_features.begin(), pruned_features.end(),
+                features_.begin() + range.begin);
+      range.size = pruned_features.size();
+    }
+    auto new_weight = ComputeWeight(pruned_features, fs, coverage_frontier);
     weighted_distribution_.ChangeWeight(i, new_weight);
     if (new_weight == 0) ++num_zero_weights;
   }
@@ -112,41 +214,80 @@ size_t Corpus::Prune(const FeatureSet &fs,
   // Also remove some random elements, if the corpus is still too big.
   // The corpus must not be empty, hence target_size is at least 1.
   // It should also be <= max_corpus_size.
-  size_t target_size = std::max(1UL, records_.size() - num_zero_weights);
+  size_t target_size = std::max(1UL, NumActive() - num_zero_weights);
   auto subset_to_remove =
       weighted_distribution_.RemoveRandomWeightedSubset(target_size, rng);
-  RemoveSubset(subset_to_remove, records_);
+  RemoveSubset(subset_to_remove, data_);
+  RemoveSubset(subset_to_remove, metadata_);
+  RemoveSubset(subset_to_remove, feature_ranges_);
+  RemoveSubset(subset_to_remove, frontier_node_sets_);
 
   weighted_distribution_.RecomputeInternalState();
-  CHECK(!records_.empty());
+  CHECK(!data_.empty());
 
-  // Features may have shrunk from CountUnseenAndPruneFrequentFeatures.
-  // Call shrink_to_fit for the features that survived the pruning.
-  for (auto &record : records_) {
-    record.features.shrink_to_fit();
+  if (compress_features_) {
+    CompactFeatures(compressed_features_);
+  } else {
+    CompactFeatures(features_);
   }
+  // Record indices have shifted and pruned features may have taken frontier
+  // PCs with them.
+  RebuildFrontierIndex(coverage_frontier);
 
   num_pruned_ += subset_to_remove.size();
   return subset_to_remove.size();
 }
 
+template <typename Arena>
+void Corpus::CompactFeatures(Arena &arena) {
+  // In place: the ranges stay in order, so every range moves towards the
+  // beginning.
+  size_t arena_size = 0;
+  for (auto &range : feature_ranges_) {
+    std::copy(arena.begin() + range.begin,
+              arena.begin() + range.begin + range.size,
+              arena.begin() + arena_size);
+    range.begin = arena_size;
+    arena_size += range.size;
+  }
+  arena.resize(arena_size);
+  // Release the memory if the corpus shrank a lot.
+  if (arena.capacity() > 2 * arena.size()) arena.shrink_to_fit();
+}
+
 void Corpus::Add(const ByteArray &data, const FeatureVec &fv,
                  const ExecutionMetadata &metadata, const FeatureSet &fs,
                  const CoverageFrontier &coverage_frontier) {
   // TODO(kcc): use coverage_frontier.
   CHECK(!data.empty())
       << "Got request to add empty element to corpus: ignoring";
-  CHECK_EQ(records_.size(), weighted_distribution_.size());
-  records_.push_back({data, fv, metadata});
+  CHECK_EQ(NumActive(), weighted_distribution_.size());
+  data_.push_back(data);
+  metadata_.push_back(metadata);
+  if (compress_features_) {
+    features_scratch_.assign(fv.begin(), fv.end());
+    std::sort(features_scratch_.begin(), features_scratch_.end());
+    const size_t begin = compressed_features_.size();
+    CompressSortedFeatures(features_scratch_, compressed_features_);
+    feature_ranges_.push_back({begin, compressed_features_.size() - begin});
+  } else {
+    feature_ranges_.push_back({features_.size(), fv.size()});
+    features_.insert(features_.end(), fv.begin(), fv.end());
+  }
+  frontier_node_sets_.emplace_back();
+  if (records_by_pc_.size() < coverage_frontier.MaxPcIndex()) {
+    records_by_pc_.resize(coverage_frontier.MaxPcIndex());
+  }
+  AddToFrontierIndex(coverage_frontier, NumActive() - 1);
   weighted_distribution_.AddWeight(ComputeWeight(fv, fs, coverage_frontier));
 }
 
-const CorpusRecord &Corpus::WeightedRandom(size_t random) const {
-  return records_[weighted_distribution_.RandomIndex(random)];
+size_t Corpus::WeightedRandomIndex(size_t random) const {
+  return weighted_distribution_.RandomIndex(random);
 }
 
-const CorpusRecord &Corpus::UniformRandom(size_t random) const {
-  return records_[random % records_.size()];
+size_t Corpus::UniformRandomIndex(size_t random) const {
+  return random % NumActive();
 }
 
 void Corpus::DumpStatsToFile(const FeatureSet &fs, std::string_view filepath,
@@ -165,18 +306,17 @@ void Corpus::DumpStatsToFile(const FeatureSet &fs, std::string_view filepath,
 }
 )";
   const std::string header_str =
-      absl::Substitute(kHeaderStub, description, records_.size());
+      absl::Substitute(kHeaderStub, description, NumActive());
   CHECK_OK(RemoteFileAppend(file, header_str));
   std::string before_record;
-  for (const auto &record : records_) {
+  for (size_t i = 0, n = NumActive(); i < n; ++i) {
     std::vector<size_t> frequencies;
-    frequencies.reserve(record.features.size());
-    for (const auto feature : record.features) {
+    ForEachFeature(i, [&](feature_t feature) {
       frequencies.push_back(fs.Frequency(feature));
-    }
+    });
     const std::string frequencies_str = absl::StrJoin(frequencies, ", ");
     const std::string record_str = absl::Substitute(
-        kRecordStub, before_record, record.data.size(), frequencies_str);
+        kRecordStub, before_record, data_[i].size(), frequencies_str);
     CHECK_OK(RemoteFileAppend(file, record_str));
     before_record = ",";
   }
@@ -186,11 +326,11 @@ void Corpus::DumpStatsToFile(const FeatureSet &fs, std::string_view filepath,
 
 std::string Corpus::MemoryUsageString() const {
   size_t data_size = 0;
-  size_t features_size = 0;
-  for (const auto &record : records_) {
-    data_size += record.data.capacity() * sizeof(record.data[0]);
-    features_size += record.features.capacity() * sizeof(record.features[0]);
+  for (const auto &data : data_) {
+    data_size += data.capacity() * sizeof(data[0]);
   }
+  const size_t features_size = features_.capacity() * sizeof(features_[0]) +
+                               compressed_features_.capacity();
   return absl::StrCat("d", data_size >> 20, "/f", features_size >> 20);
 }
 
@@ -247,134 +387,318 @@ uint64_t WeightedDistribution::PopBack() {
 }
 
 //------------------------------------------------------------------------------
-//                            CoverageFrontier
+//                            WeightedSumTree
 //------------------------------------------------------------------------------
 
+void WeightedSumTree::Assign(absl::Span<const uint64_t> weights) {
+  const size_t n = weights.size();
+  weights_.assign(weights.begin(), weights.end());
+  tree_.assign(n + 1, 0);
+  total_weight_ = 0;
+  for (size_t i = 1; i <= n; ++i) {
+    tree_[i] += weights[i - 1];
+    total_weight_ += weights[i - 1];
+    const size_t parent = i + (i & -i);
+    if (parent <= n) tree_[parent] += tree_[i];
+  }
+  top_step_ = 0;
+  if (n != 0) {
+    top_step_ = 1;
+    while (top_step_ <= n / 2) top_step_ *= 2;
+  }
+}
 
-void CoverageFrontier::UpdateGlobalFrontierSet(const std::vector<CorpusRecord> &corpus_records) {
-  std::fill(frontier_.begin(), frontier_.end(), false);
+void WeightedSumTree::SetWeight(size_t idx, uint64_t new_weight) {
+  CHECK_LT(idx, size());
+  // Unsigned wrap-around makes this work for decreasing weights, too.
+  const uint64_t delta = new_weight - weights_[idx];
+  weights_[idx] = new_weight;
+  total_weight_ += delta;
+  for (size_t i = idx + 1; i < tree_.size(); i += i & -i) tree_[i] += delta;
+}
 
-  // A vector of covered indices in pc_table. Needed for Coverage object.
-  PCIndexVec covered_pcs;
-  for (const auto &record : corpus_records) {
-    for (auto feature : record.features) {
-      if (!feature_domains::kPCs.Contains(feature)) continue;
-      size_t idx = ConvertPCFeatureToPcIndex(feature);
-      if (idx >= binary_info_.pc_table.size()) continue;
-      covered_pcs.push_back(idx);
+size_t WeightedSumTree::RandomIndex(size_t random) const {
+  CHECK_NE(total_weight_, 0);
+  // Finds the first index whose prefix sum exceeds `remaining`, descending
+  // the implicit tree from the top.
+  uint64_t remaining = random % total_weight_;
+  size_t pos = 0;
+  for (size_t step = top_step_; step != 0; step /= 2) {
+    if (pos + step < tree_.size() && tree_[pos + step] <= remaining) {
+      pos += step;
+      remaining -= tree_[pos];
     }
   }
+  CHECK_LT(pos, size());
+  return pos;
+}
+
+//------------------------------------------------------------------------------
+//                            CoverageFrontier
+//------------------------------------------------------------------------------
+
 
-  Coverage coverage(binary_info_.pc_table, covered_pcs);
+void CoverageFrontier::ResetGlobalFrontier() {
+  const size_t num_pcs = MaxPcIndex();
+  if (predecessor_offsets_.empty()) {
+    InitPredecessorIndex();
+    InitFunctionIndex();
+  }
+  covered_.assign(num_pcs, false);
+  global_frontier_.assign(num_pcs, false);
+  num_global_frontier_nodes_ = 0;
+  global_frontier_changes_.clear();
+  global_frontier_changed_.assign(num_pcs, false);
+  global_frontier_reset_ = true;
+  // Nothing is covered yet: every edge counts as an uncovered successor.
+  num_uncovered_successors_.assign(num_pcs, 0);
+  for (const PCIndex predecessor : predecessors_) {
+    ++num_uncovered_successors_[predecessor];
+  }
+  // With nothing covered there is no frontier, and all weights are 0.
+  function_num_covered_.assign(num_pcs, 0);
+  num_functions_in_frontier_ = 0;
+  std::fill(frontier_weight_.begin(), frontier_weight_.end(), 0);
+  stale_weight_functions_.clear();
+  function_weights_stale_.assign(num_pcs, false);
+}
 
-  IteratePcTableFunctions(binary_info_.pc_table, [this, &coverage](size_t beg,
-                                                                   size_t end) {
-    auto frontier_begin = frontier_.begin() + beg;
-    auto frontier_end = frontier_.begin() + end;
+void CoverageFrontier::InitPredecessorIndex() {
+  const size_t num_pcs = MaxPcIndex();
+  const auto &cfg = binary_info_.control_flow_graph;
+  predecessor_offsets_.assign(num_pcs + 1, 0);
+  // Count the predecessors of every PC, then fill predecessors_.
+  for (size_t i = 0; i < num_pcs; ++i) {
+    const auto pc = binary_info_.pc_table[i].pc;
+    if (!cfg.exists(pc)) continue;
+    for (auto successor : cfg.GetSuccessors(pc)) {
+      // Successor pc may not be in PCTable because of pruning.
+      if (!cfg.IsInPcTable(successor)) continue;
+      ++predecessor_offsets_[cfg.GetPcIndex(successor) + 1];
+    }
+  }
+  for (size_t i = 0; i < num_pcs; ++i) {
+    predecessor_offsets_[i + 1] += predecessor_offsets_[i];
+  }
+  predecessors_.resize(predecessor_offsets_[num_pcs]);
+  std::vector<uint32_t> fill(predecessor_offsets_.begin(),
+                             predecessor_offsets_.end() - 1);
+  for (size_t i = 0; i < num_pcs; ++i) {
+    const auto pc = binary_info_.pc_table[i].pc;
+    if (!cfg.exists(pc)) continue;
+    for (auto successor : cfg.GetSuccessors(pc)) {
+      if (!cfg.IsInPcTable(successor)) continue;
+      predecessors_[fill[cfg.GetPcIndex(successor)]++] = i;
+    }
+  }
+}
 
-    // Iterate over BBs in the function and check the coverage statue.
-    for (size_t i = beg; i < end; ++i) {
-      // If the current pc is not covered, it cannot be a frontier.
-      if (!coverage.BlockIsCovered(i)) continue;
+void CoverageFrontier::InitFunctionIndex() {
+  const size_t num_pcs = MaxPcIndex();
+  const auto &cfg = binary_info_.control_flow_graph;
+  function_entry_.assign(num_pcs, 0);
+  function_size_.assign(num_pcs, 0);
+  // A function spans from its kFuncEntry PC to the next one.
+  PCIndex entry = 0;
+  for (size_t i = 0; i < num_pcs; ++i) {
+    if (binary_info_.pc_table[i].has_flag(PCInfo::kFuncEntry)) entry = i;
+    function_entry_[i] = entry;
+    ++function_size_[entry];
+  }
 
-      auto pc = binary_info_.pc_table[i].pc;
-      // Current pc is covered, look for a non-covered successor.
-      for (auto successor : binary_info_.control_flow_graph.GetSuccessors(pc)) {
-        // Successor pc may not be in PCTable because of pruning.
-        if (!binary_info_.control_flow_graph.IsInPcTable(successor)) continue;
+  // Collect the (callee, caller) function pairs, then build the CSR index.
+  std::vector<std::pair<PCIndex, PCIndex>> calls;
+  for (size_t i = 0; i < num_pcs; ++i) {
+    const auto pc = binary_info_.pc_table[i].pc;
+    if (!cfg.exists(pc)) continue;
+    for (auto callee : binary_info_.call_graph.GetBasicBlockCallees(pc)) {
+      if (callee == -1ULL || !cfg.IsInPcTable(callee)) continue;
+      calls.emplace_back(cfg.GetPcIndex(callee), function_entry_[i]);
+    }
+  }
+  std::sort(calls.begin(), calls.end());
+  calls.erase(std::unique(calls.begin(), calls.end()), calls.end());
+  callers_offsets_.assign(num_pcs + 1, 0);
+  callers_.clear();
+  callers_.reserve(calls.size());
+  for (const auto &[callee, caller] : calls) {
+    ++callers_offsets_[callee + 1];
+    callers_.push_back(caller);
+  }
+  for (size_t i = 0; i < num_pcs; ++i) {
+    callers_offsets_[i + 1] += callers_offsets_[i];
+  }
+}
 
-        auto successor_idx = binary_info_.control_flow_graph.GetPcIndex(successor);
+void CoverageFrontier::UpdateGlobalFrontierStatus(PCIndex idx) {
+  const bool is_frontier = covered_[idx] && num_uncovered_successors_[idx] != 0;
+  if (is_frontier == global_frontier_[idx]) return;
+  global_frontier_[idx] = is_frontier;
+  if (!global_frontier_changed_[idx]) {
+    global_frontier_changed_[idx] = true;
+    global_frontier_changes_.push_back(idx);
+  }
+  if (is_frontier) {
+    ++num_global_frontier_nodes_;
+  } else {
+    --num_global_frontier_nodes_;
+  }
+}
 
-        // This successor is covered, skip it.
-        if (coverage.BlockIsCovered(successor_idx)) continue;
+void CoverageFrontier::InvalidateFunctionWeights(PCIndex entry) {
+  if (function_weights_stale_[entry]) return;
+  function_weights_stale_[entry] = true;
+  stale_weight_functions_.push_back(entry);
+}
 
-        frontier_[i] = true;
-      }
+void CoverageFrontier::MarkCovered(PCIndex idx) {
+  if (covered_[idx]) return;
+  covered_[idx] = true;
+  // `idx` is no longer an uncovered successor of its predecessors, some of
+  // them may leave the frontier. `idx` itself may enter it.
+  for (uint32_t i = predecessor_offsets_[idx]; i < predecessor_offsets_[idx + 1];
+       ++i) {
+    const PCIndex predecessor = predecessors_[i];
+    --num_uncovered_successors_[predecessor];
+    UpdateGlobalFrontierStatus(predecessor);
+  }
+  UpdateGlobalFrontierStatus(idx);
+
+  // The CFG is intra-procedural: the frontier PCs affected above, and the
+  // regions reachable from them, are all in this function.
+  const PCIndex entry = function_entry_[idx];
+  const uint32_t size = function_size_[entry];
+  const uint32_t num_covered = ++function_num_covered_[entry];
+  if (num_covered == 1 && size > 1) ++num_functions_in_frontier_;
+  if (num_covered == size && size > 1) --num_functions_in_frontier_;
+  InvalidateFunctionWeights(entry);
+  // Covering the entry makes the function partially covered, covering the
+  // last PC makes it fully covered: the weights of its callers change.
+  if (idx == entry || num_covered == size) {
+    for (uint32_t i = callers_offsets_[entry]; i < callers_offsets_[entry + 1];
+         ++i) {
+      InvalidateFunctionWeights(callers_[i]);
     }
-  });
+  }
 }
 
-size_t CoverageFrontier::Compute(const Corpus &corpus) {
-  return Compute(corpus.Records());
+void CoverageFrontier::AddCoverage(absl::Span<const feature_t> fv) {
+  if (MaxPcIndex() == 0) return;
+  if (covered_.empty()) ResetGlobalFrontier();
+  for (auto feature : fv) {
+    if (!feature_domains::kPCs.Contains(feature)) continue;
+    size_t idx = ConvertPCFeatureToPcIndex(feature);
+    if (idx >= MaxPcIndex()) continue;
+    MarkCovered(idx);
+  }
 }
 
-size_t CoverageFrontier::Compute(
-    const std::vector<CorpusRecord> &corpus_records) {
-  // Initialize the vectors.
-  std::fill(frontier_.begin(), frontier_.end(), false);
-  std::fill(frontier_weight_.begin(), frontier_weight_.end(), 0);
+void CoverageFrontier::ClearGlobalFrontierChanges() {
+  for (const PCIndex idx : global_frontier_changes_) {
+    global_frontier_changed_[idx] = false;
+  }
+  global_frontier_changes_.clear();
+  global_frontier_reset_ = false;
+}
 
-  // A vector of covered indices in pc_table. Needed for Coverage object.
-  PCIndexVec covered_pcs;
+void CoverageFrontier::UpdateGlobalFrontierSet(
+    const std::vector<CorpusRecord> &corpus_records) {
+  if (MaxPcIndex() == 0) return;
+  ResetGlobalFrontier();
   for (const auto &record : corpus_records) {
-    for (auto feature : record.features) {
-      if (!feature_domains::kPCs.Contains(feature)) continue;
-      size_t idx = ConvertPCFeatureToPcIndex(feature);
-      if (idx >= binary_info_.pc_table.size()) continue;
-      covered_pcs.push_back(idx);
-      frontier_[idx] = true;
-    }
+    AddCoverage(record.features);
   }
+}
 
-  Coverage coverage(binary_info_.pc_table, covered_pcs);
+void CoverageFrontier::UpdateGlobalFrontierSet(const Corpus &corpus) {
+  if (MaxPcIndex() == 0) return;
+  ResetGlobalFrontier();
+  FeatureVec features_scratch;
+  for (size_t i = 0, n = corpus.NumActive(); i < n; ++i) {
+    AddCoverage(corpus.GetFeatures(i, features_scratch));
+  }
+}
 
-  num_functions_in_frontier_ = 0;
-  IteratePcTableFunctions(binary_info_.pc_table, [this, &coverage](size_t beg,
-                                                                   size_t end) {
-    auto frontier_begin = frontier_.begin() + beg;
-    auto frontier_end = frontier_.begin() + end;
-    size_t cov_size_in_this_func =
-        std::count(frontier_begin, frontier_end, true);
-
-    if (cov_size_in_this_func > 0 && cov_size_in_this_func < end - beg)
-      ++num_functions_in_frontier_;
-
-    // Reset the frontier_ entries.
-    std::fill(frontier_begin, frontier_end, false);
-
-    // Iterate over BBs in the function and check the coverage statue.
-    for (size_t i = beg; i < end; ++i) {
-      // If the current pc is not covered, it cannot be a frontier.
-      if (!coverage.BlockIsCovered(i)) continue;
-
-      auto pc = binary_info_.pc_table[i].pc;
-
-      // Current pc is covered, look for a non-covered successor.
-      for (auto successor : binary_info_.control_flow_graph.GetSuccessors(pc)) {
-        // Successor pc may not be in PCTable because of pruning.
-        if (!binary_info_.control_flow_graph.IsInPcTable(successor)) continue;
-
-        auto successor_idx =
-            binary_info_.control_flow_graph.GetPcIndex(successor);
-
-        // This successor is covered, skip it.
-        if (coverage.BlockIsCovered(successor_idx)) continue;
-
-        // Now we have a frontier, compute the weight.
-        frontier_[i] = true;
-
-        // Calculate frontier weight.
-        // Here we use reachability and coverage to identify all reachable and
-        // non-covered BBs from successor, and then use all functions called
-        // in those BBs.
-        for (auto reachable_bb :
-             binary_info_.control_flow_graph.LazyGetReachabilityForPc(
-                 successor)) {
-          if (!binary_info_.control_flow_graph.IsInPcTable(reachable_bb) ||
-              coverage.BlockIsCovered(
-                  binary_info_.control_flow_graph.GetPcIndex(reachable_bb))) {
-            // This reachable BB is already either processed and added or
-            // covered via a different path -- not interesting!
-            continue;
-          }
-          frontier_weight_[i] += ComputeFrontierWeight(
-              coverage, binary_info_.control_flow_graph,
-              binary_info_.call_graph.GetBasicBlockCallees(reachable_bb));
+void CoverageFrontier::ComputeFunctionWeights(PCIndex entry) {
+  const auto &cfg = binary_info_.control_flow_graph;
+  auto block_is_covered = [this](PCIndex idx) { return covered_[idx]; };
+  auto function_is_fully_covered = [this](PCIndex idx) {
+    return function_num_covered_[idx] == function_size_[idx];
+  };
+  for (size_t i = entry, end = entry + function_size_[entry]; i < end; ++i) {
+    frontier_weight_[i] = 0;
+    if (!global_frontier_[i]) continue;
+    // A frontier PC is covered and has an uncovered successor.
+    for (auto successor : cfg.GetSuccessors(binary_info_.pc_table[i].pc)) {
+      // Successor pc may not be in PCTable because of pruning.
+      if (!cfg.IsInPcTable(successor)) continue;
+      if (covered_[cfg.GetPcIndex(successor)]) continue;
+      // Here we use reachability and coverage to identify all reachable and
+      // non-covered BBs from successor, and then use all functions called
+      // in those BBs.
+      for (auto reachable_bb : cfg.LazyGetReachabilityForPc(successor)) {
+        if (!cfg.IsInPcTable(reachable_bb) ||
+            covered_[cfg.GetPcIndex(reachable_bb)]) {
+          continue;
         }
+        frontier_weight_[i] += ComputeFrontierWeight(
+            cfg, binary_info_.call_graph.GetBasicBlockCallees(reachable_bb),
+            block_is_covered, function_is_fully_covered);
       }
     }
-  });
+  }
+}
 
+void CoverageFrontier::UpdateFrontierWeights(size_t num_threads) {
+  size_t num_stale_pcs = 0;
+  for (const PCIndex entry : stale_weight_functions_) {
+    function_weights_stale_[entry] = false;
+    num_stale_pcs += function_size_[entry];
+  }
+  num_threads = std::min(num_threads, num_stale_pcs / kMinPcsPerWeightThread);
+  if (num_threads <= 1) {
+    for (const PCIndex entry : stale_weight_functions_) {
+      ComputeFunctionWeights(entry);
+    }
+    stale_weight_functions_.clear();
+    return;
+  }
+
+  // Split the stale functions into contiguous chunks of about the same
+  // number of PCs. The functions are disjoint PC ranges, so are the slices of
+  // frontier_weight_ written by different threads.
+  const size_t pcs_per_thread = (num_stale_pcs + num_threads - 1) / num_threads;
+  {
+    ThreadPool threads{static_cast<int>(num_threads)};
+    size_t chunk_begin = 0;
+    size_t chunk_pcs = 0;
+    for (size_t i = 0, n = stale_weight_functions_.size(); i < n; ++i) {
+      chunk_pcs += function_size_[stale_weight_functions_[i]];
+      if (chunk_pcs < pcs_per_thread && i + 1 < n) continue;
+      threads.Schedule([this, chunk_begin, chunk_end = i + 1]() {
+        for (size_t j = chunk_begin; j < chunk_end; ++j) {
+          ComputeFunctionWeights(stale_weight_functions_[j]);
+        }
+      });
+      chunk_begin = i + 1;
+      chunk_pcs = 0;
+    }
+  }  // The threads join here.
+  stale_weight_functions_.clear();
+}
+
+size_t CoverageFrontier::Compute(const Corpus &corpus, size_t num_threads) {
+  if (MaxPcIndex() == 0) return 0;
+  UpdateGlobalFrontierSet(corpus);
+  UpdateFrontierWeights(num_threads);
+  return num_functions_in_frontier_;
+}
+
+size_t CoverageFrontier::Compute(
+    const std::vector<CorpusRecord> &corpus_records, size_t num_threads) {
+  if (MaxPcIndex() == 0) return 0;
+  UpdateGlobalFrontierSet(corpus_records);
+  UpdateFrontierWeights(num_threads);
   return num_functions_in_frontier_;
 }
 
@@ -24,7 +24,9 @@
 #include <vector>
 
 #include "absl/log/check.h"
+#include "absl/types/span.h"
 #include "./centipede/binary_info.h"
+#include "./centipede/control_flow.h"
 #include "./centipede/execution_metadata.h"
 #include "./centipede/feature.h"
 #include "./centipede/feature_set.h"
@@ -81,21 +83,63 @@ class WeightedDistribution {
   bool cumulative_weights_valid_ = true;
 };
 
+// WeightedSumTree maintains an array of integer weights in a Fenwick tree.
+// Unlike with WeightedDistribution, changing a weight and computing a random
+// index both take O(log(size())), so weights can change between random picks
+// at no extra cost. Indices with weight 0 are never picked.
+class WeightedSumTree {
+ public:
+  // Replaces all weights with `weights`. Takes O(size()).
+  void Assign(absl::Span<const uint64_t> weights);
+  // Changes the existing idx-th weight to new_weight.
+  void SetWeight(size_t idx, uint64_t new_weight);
+  // Returns a random number in [0,size()) with a non-zero weight, using a
+  // random number `random`, which should come from a 64-bit RNG.
+  // Precondition: total_weight() > 0.
+  size_t RandomIndex(size_t random) const;
+  // Returns the idx-th weight.
+  uint64_t weight(size_t idx) const { return weights_[idx]; }
+  // Returns the sum of all weights.
+  uint64_t total_weight() const { return total_weight_; }
+  // Returns the number of weights.
+  size_t size() const { return weights_.size(); }
+
+ private:
+  std::vector<uint64_t> weights_;
+  // 1-based: tree_[i] is the sum of weights_[i - (i & -i), i).
+  std::vector<uint64_t> tree_;
+  uint64_t total_weight_ = 0;
+  // The largest power of 2 <= size(), or 0 if empty.
+  size_t top_step_ = 0;
+};
+
 class CoverageFrontier;  // Forward decl, used in Corpus.
 
-// Input data and metadata.
+// Input data and metadata, as used outside of Corpus.
 struct CorpusRecord {
   ByteArray data;
   FeatureVec features;
   ExecutionMetadata metadata;
-  std::set<size_t> frontier_node_set;     // frontier node idx for each seed
 };
 
 // Maintains the corpus of inputs.
 // Allows to prune (forget) inputs that become uninteresting.
+//
+// The records are stored by column, each indexed by the record index. The
+// features of all records are packed in one arena, compacted by Prune(), so
+// that the per-record heap overhead and the fragmentation of the largest
+// column go away, and so that the loops over the features of all records read
+// memory sequentially. Record indices are the handles of the records; Prune()
+// shifts them.
+//
+// Optionally, the features of every record are sorted and compressed (see
+// feature_compression.h), and are decompressed one record at a time.
 class Corpus {
  public:
   Corpus() = default;
+  // If `compress_features` is true, the features are kept compressed.
+  explicit Corpus(bool compress_features)
+      : compress_features_(compress_features) {}
 
   Corpus(const Corpus &) = default;
   Corpus(Corpus &&) noexcept = default;
@@ -119,26 +163,38 @@ class Corpus {
 
   // Accessors.
 
-  // Returns the inputs.
-  const std::vector<CorpusRecord> &Records() const { return records_; }
   // Returns the total number of inputs added.
   size_t NumTotal() const { return num_pruned_ + NumActive(); }
   // Return the number of currently active inputs, i.e. inputs that we want to
   // keep mutating.
-  size_t NumActive() const { return records_.size(); }
+  size_t NumActive() const { return data_.size(); }
   // Returns the max and avg sizes of the inputs.
   std::pair<size_t, size_t> MaxAndAvgSize() const;
-  // Returns a random active corpus record using weighted distribution.
-  // See WeightedDistribution.
-  const CorpusRecord &WeightedRandom(size_t random) const;
-  // Returns a random active corpus record using uniform distribution.
-  const CorpusRecord &UniformRandom(size_t random) const;
+  // Returns the index of a random active corpus record using weighted
+  // distribution. See WeightedDistribution.
+  size_t WeightedRandomIndex(size_t random) const;
+  // Returns the index of a random active corpus record using uniform
+  // distribution.
+  size_t UniformRandomIndex(size_t random) const;
   // Returns the element with index 'idx', where `idx` < NumActive().
-  const ByteArray &Get(size_t idx) const { return records_[idx].data; }
+  const ByteArray &Get(size_t idx) const { return data_[idx]; }
   // Returns the execution metadata for the element `idx`, `idx` < NumActive().
   const ExecutionMetadata &GetMetadata(size_t idx) const {
-    return records_[idx].metadata;
+    return metadata_[idx];
+  }
+  // Returns the features of the element `idx`, `idx` < NumActive(). Valid
+  // until the next Add() or Prune(). If the features are compressed, they are
+  // decompressed into `scratch` and are sorted; otherwise `scratch` is unused.
+  absl::Span<const feature_t> GetFeatures(size_t idx,
+                                          FeatureVec &scratch) const;
+  // Returns the sorted PC indices of the features of the element `idx`,
+  // `idx` < NumActive(), that are in the global frontier.
+  const PCIndexVec &GetFrontierNodeSet(size_t idx) const {
+    return frontier_node_sets_[idx];
   }
+  // Returns the sorted indices of the records having PC feature `pc_index`.
+  // Valid until the next Add() or Prune().
+  const std::vector<uint32_t> &RecordsWithPc(PCIndex pc_index) const;
 
   // Logging.
 
@@ -149,13 +205,61 @@ class Corpus {
   // Returns a string used for logging the corpus memory usage.
   std::string MemoryUsageString() const;
 
-  // update frontier node set for each corpus record
-  void UpdateFrontierNodeSetForCorpus(const CoverageFrontier &);
+  // Applies the global frontier changes since the last
+  // CoverageFrontier::ClearGlobalFrontierChanges() to the GetFrontierNodeSet()
+  // of the records having the changed PCs.
+  // The cost is proportional to the number of changed (PC, record) pairs.
+  void UpdateFrontierNodeSetForCorpus(const CoverageFrontier &coverage_frontier);
+  // Same as above, but for the global frontier PCs in `changed_pcs`, e.g. the
+  // changes of a frontier shared with other corpora.
+  void UpdateFrontierNodeSetForCorpus(const CoverageFrontier &coverage_frontier,
+                                      absl::Span<const PCIndex> changed_pcs);
 
 
  private:
-  std::vector<CorpusRecord> records_;
-  // Maintains weights for elements of records_.
+  // Rebuilds records_by_pc_ and all frontier_node_sets_.
+  void RebuildFrontierIndex(const CoverageFrontier &coverage_frontier);
+  // Computes frontier_node_sets_[idx] and adds `idx` to records_by_pc_ for
+  // every PC feature of record `idx`.
+  void AddToFrontierIndex(const CoverageFrontier &coverage_frontier,
+                          size_t idx);
+  // Calls `callback(feature)` for every feature of record `idx`. Compressed
+  // features are decoded on the fly, not into a vector.
+  template <typename Callback>
+  void ForEachFeature(size_t idx, Callback callback) const;
+  // Moves the features of the records in `arena` over the gaps left by
+  // Prune(), shrinks `arena`.
+  template <typename Arena>
+  void CompactFeatures(Arena &arena);
+
+  // The features of record `idx` are features_[begin, begin + size) of
+  // feature_ranges_[idx], or compressed_features_[begin, begin + size) if
+  // compress_features_.
+  struct FeatureRange {
+    size_t begin;
+    size_t size;
+  };
+
+  bool compress_features_ = false;
+
+  // The columns of the records.
+  std::vector<ByteArray> data_;
+  std::vector<ExecutionMetadata> metadata_;
+  std::vector<FeatureRange> feature_ranges_;
+  // Sorted PC indices of the record's features that are in the global
+  // frontier.
+  std::vector<PCIndexVec> frontier_node_sets_;
+  // The features of all the records, in the order of the records. Only one of
+  // the two is used, depending on compress_features_.
+  FeatureVec features_;
+  ByteArray compressed_features_;
+  // Scratch space for the features of one record.
+  FeatureVec features_scratch_;
+
+  // records_by_pc_[pc_index] are the indices of the records having that PC
+  // feature. Appended to by Add(), rebuilt by Prune().
+  std::vector<std::vector<uint32_t>> records_by_pc_;
+  // Maintains weights for the records.
   WeightedDistribution weighted_distribution_;
   size_t num_pruned_ = 0;
 };
@@ -166,55 +270,167 @@ class Corpus {
 // Frontier weight is a representation of how much code is behind the
 // frontier. Therefore, it should be used to prioritize which frontier to focus
 // first.
+//
+// The frontier is maintained incrementally: AddCoverage() updates the
+// frontier bits and the per-function counts around the newly covered PCs
+// only. Frontier weights are cached and recomputed by UpdateFrontierWeights()
+// only for the functions whose weights may have changed since: the ones with
+// newly covered PCs, and the callers of functions whose coverage kind
+// (uncovered, partially or fully covered) changed.
 class CoverageFrontier {
  public:
   explicit CoverageFrontier(const BinaryInfo &binary_info)
       : binary_info_(binary_info),
-        frontier_(binary_info.pc_table.size()),
         frontier_weight_(binary_info.pc_table.size()) {}
 
-  // Computes the coverage frontier of `corpus`.
-  // Returns the number of functions in the frontier.
-  size_t Compute(const Corpus &corpus);
+  // Recomputes the coverage frontier and its weights from scratch from the
+  // coverage of `corpus`, forgetting the coverage added before. The weights
+  // are computed using up to `num_threads` threads, see
+  // UpdateFrontierWeights(). Returns the number of functions in the frontier.
+  size_t Compute(const Corpus &corpus, size_t num_threads = 1);
 
   // Same as above.
-  size_t Compute(const std::vector<CorpusRecord> &corpus_records);
+  size_t Compute(const std::vector<CorpusRecord> &corpus_records,
+                 size_t num_threads = 1);
 
-  // Returns the number of functions in the frontier.
+  // Returns the number of functions in the frontier, i.e. the partially
+  // covered ones.
   size_t NumFunctionsInFrontier() const { return num_functions_in_frontier_; }
 
   // Returns true iff `idx` belongs to the frontier.
   bool PcIndexIsFrontier(size_t idx) const {
     CHECK_LT(idx, MaxPcIndex());
-    return frontier_[idx];
+    return !global_frontier_.empty() && global_frontier_[idx];
   }
 
   // Returns the size of the pc_table used to create `this`.
   size_t MaxPcIndex() const { return binary_info_.pc_table.size(); }
 
   // Returns the frontier weight of pc at `idx`, weight of a non-frontier is 0.
+  // The weight is as of the last UpdateFrontierWeights() or Compute().
   uint64_t FrontierWeight(size_t idx) const {
     CHECK_LT(idx, MaxPcIndex());
     return frontier_weight_[idx];
   }
 
-  size_t NumGlobalFrontierNodes() const {
-    return std::count(frontier_.begin(), frontier_.end(), true);
+  // Marks the PCs in `fv` as covered and updates the frontier around the
+  // newly covered PCs only. Inputs must be passed here once their features
+  // are known to be new, e.g. next to FeatureSet::IncrementFrequencies.
+  // Coverage is never removed: like the FeatureSet, the frontier keeps the
+  // PCs of inputs that Corpus::Prune() later dropped. Use
+  // UpdateGlobalFrontierSet() for the frontier of the surviving records only.
+  void AddCoverage(absl::Span<const feature_t> fv);
+
+  // Recomputes the weights invalidated by AddCoverage() since the last call.
+  // The cost is proportional to the size of the affected functions. With
+  // `num_threads` > 1 and enough work (see kMinPcsPerWeightThread), the
+  // affected functions are partitioned across that many threads, each
+  // writing the weights of its own functions only.
+  void UpdateFrontierWeights(size_t num_threads = 1);
+
+  // The minimal number of PCs in the affected functions per thread used by
+  // UpdateFrontierWeights(): smaller updates are not worth a thread.
+  static constexpr size_t kMinPcsPerWeightThread = 1 << 12;
+
+  // The "global frontier" names used by the seed scheduling: the same as the
+  // frontier above.
+
+  // Returns true iff `idx` belongs to the global frontier.
+  bool PcIndexIsGlobalFrontier(size_t idx) const {
+    return PcIndexIsFrontier(idx);
   }
 
-  void UpdateGlobalFrontierSet(const std::vector<CorpusRecord> &);
+  // Returns the number of PCs in the global frontier.
+  size_t NumGlobalFrontierNodes() const { return num_global_frontier_nodes_; }
+
+  // Recomputes the global frontier from scratch from `corpus_records`. The
+  // weights are recomputed lazily, by UpdateFrontierWeights().
+  void UpdateGlobalFrontierSet(const std::vector<CorpusRecord> &corpus_records);
+  // Same as above, from the records of `corpus`.
+  void UpdateGlobalFrontierSet(const Corpus &corpus);
+
+  // Returns the PCs that entered or left the global frontier since the last
+  // ClearGlobalFrontierChanges(), each once; PcIndexIsGlobalFrontier() tells
+  // which. Meaningless if GlobalFrontierWasReset().
+  const PCIndexVec &GlobalFrontierChanges() const {
+    return global_frontier_changes_;
+  }
+  // Returns true iff the global frontier was recomputed from scratch since the
+  // last ClearGlobalFrontierChanges(), so that every PC may have changed.
+  bool GlobalFrontierWasReset() const { return global_frontier_reset_; }
+  // Returns true iff anything changed since the last
+  // ClearGlobalFrontierChanges().
+  bool HasGlobalFrontierChanges() const {
+    return global_frontier_reset_ || !global_frontier_changes_.empty();
+  }
+  // Forgets the changes, to be called once all users have seen them.
+  void ClearGlobalFrontierChanges();
 
  private:
+  // Builds predecessor_offsets_ and predecessors_ from the CFG.
+  void InitPredecessorIndex();
+  // Builds function_entry_, function_size_ and the callers_ index.
+  void InitFunctionIndex();
+  // Resets the frontier to "nothing covered".
+  void ResetGlobalFrontier();
+  // Marks `idx` as covered and updates the frontier status of it and of its
+  // predecessors, the function counts and the stale weights.
+  void MarkCovered(PCIndex idx);
+  // Recomputes global_frontier_[idx] from covered_ and the successor count.
+  void UpdateGlobalFrontierStatus(PCIndex idx);
+  // Schedules the weights of the function entered at `entry` for
+  // recomputation.
+  void InvalidateFunctionWeights(PCIndex entry);
+  // Recomputes frontier_weight_ for the PCs of the function entered at
+  // `entry`. Only reads the coverage state, so may run concurrently for
+  // different functions.
+  void ComputeFunctionWeights(PCIndex entry);
+
   const BinaryInfo &binary_info_;
 
-  // frontier_[idx] is true iff pc_table_[i] is part of the coverage frontier.
-  std::vector<bool> frontier_;
-  // Stores the weight associated with frontier_[idx].
+  // Stores the weight associated with the frontier PC at idx.
   std::vector<uint64_t> frontier_weight_;
 
   // The number of functions in the frontier.
   size_t num_functions_in_frontier_ = 0;
 
+  // State of the frontier, see AddCoverage(). All vectors are empty until
+  // first use, then have MaxPcIndex() elements (offsets have one more).
+  // covered_[idx] is true iff pc_table[idx] was covered by some input.
+  std::vector<bool> covered_;
+  // global_frontier_[idx] is true iff pc_table[idx] is in the frontier.
+  std::vector<bool> global_frontier_;
+  size_t num_global_frontier_nodes_ = 0;
+  // The number of CFG successors of every PC that are in the pc_table but not
+  // covered, counted with multiplicity.
+  std::vector<uint32_t> num_uncovered_successors_;
+  // The in-pc_table CFG predecessors of PC index `idx` are
+  // predecessors_[predecessor_offsets_[idx] .. predecessor_offsets_[idx + 1]).
+  std::vector<uint32_t> predecessor_offsets_;
+  PCIndexVec predecessors_;
+  // PCs whose global frontier status changed since the last
+  // ClearGlobalFrontierChanges(), as a list and as a bitset.
+  PCIndexVec global_frontier_changes_;
+  std::vector<bool> global_frontier_changed_;
+  // True iff the global frontier was recomputed from scratch since the last
+  // ClearGlobalFrontierChanges(): every PC counts as changed.
+  bool global_frontier_reset_ = false;
+
+  // Functions are identified by the pc_table index of their entry.
+  // function_entry_[idx] is the function of pc_table[idx].
+  PCIndexVec function_entry_;
+  // The number of PCs of, and the number of covered PCs of, the function
+  // entered at idx; 0 for non-entries.
+  std::vector<uint32_t> function_size_;
+  std::vector<uint32_t> function_num_covered_;
+  // The functions having a call to the function entered at `idx`, each once,
+  // are callers_[callers_offsets_[idx] .. callers_offsets_[idx + 1]).
+  std::vector<uint32_t> callers_offsets_;
+  PCIndexVec callers_;
+  // Functions whose weights are stale, as a list and as a bitset indexed by
+  // the entry.
+  PCIndexVec stale_weight_functions_;
+  std::vector<bool> function_weights_stale_;
 };
 
 }  // namespace centipede
@@ -13,15 +13,20 @@
 // limitations under the License.
 #include "./centipede/corpus_io.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
-#include <map>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -29,6 +34,7 @@
 #include "absl/types/span.h"
 #include "./centipede/feature.h"
 #include "./centipede/rusage_profiler.h"
+#include "./centipede/thread_pool.h"
 #include "./centipede/util.h"
 #include "./common/blob_file.h"
 #include "./common/defs.h"
@@ -38,6 +44,28 @@
 
 namespace centipede {
 
+namespace {
+
+// The inputs are hashed by chunks of this many, on up to kMaxHashThreads
+// threads, while the following inputs are read.
+constexpr size_t kInputsPerHashChunk = 1024;
+constexpr size_t kMaxHashThreads = 8;
+
+// A chunk of inputs and, once hashed, their hashes.
+struct InputChunk {
+  std::vector<ByteArray> inputs;
+  std::vector<HashDigest> hashes;
+};
+
+void HashInputChunk(InputChunk &chunk) {
+  chunk.hashes.reserve(chunk.inputs.size());
+  for (const ByteArray &input : chunk.inputs) {
+    chunk.hashes.push_back(HashDigestOf(input));
+  }
+}
+
+}  // namespace
+
 void ReadShard(std::string_view corpus_path, std::string_view features_path,
                const std::function<void(ByteArray, FeatureVec)> &callback) {
   const bool good_corpus_path =
@@ -56,73 +84,108 @@ void ReadShard(std::string_view corpus_path, std::string_view features_path,
       /*timelapse_interval=*/absl::Seconds(30),  //
       /*also_log_timelapses=*/false);
 
-  // Maps input hashes to inputs.
-  // NOTE: Using `std::multimap` to prevent auto-deduplication of inputs.
+  // If the features file is not passed or doesn't exist, simply ignore it.
+  if (!good_features_path) {
+    LOG(WARNING) << "Features file path empty or not found - ignoring: "
+                 << features_path;
+  }
+
+  // Read inputs from the corpus file. Every full chunk is hashed on
+  // `hash_threads`, started at the first one, while the next one is read.
+  std::vector<std::unique_ptr<InputChunk>> chunks;
+  {
+    std::optional<ThreadPool> hash_threads;
+    auto corpus_reader = DefaultBlobFileReaderFactory();
+    CHECK_OK(corpus_reader->Open(corpus_path)) << VV(corpus_path);
+    chunks.push_back(std::make_unique<InputChunk>());
+    ByteSpan blob;
+    while (corpus_reader->Read(blob).ok()) {
+      if (chunks.back()->inputs.size() == kInputsPerHashChunk) {
+        if (!hash_threads.has_value()) {
+          hash_threads.emplace(static_cast<int>(std::clamp<size_t>(
+              std::thread::hardware_concurrency(), 1, kMaxHashThreads)));
+        }
+        hash_threads->Schedule(
+            [chunk = chunks.back().get()] { HashInputChunk(*chunk); });
+        chunks.push_back(std::make_unique<InputChunk>());
+      }
+      chunks.back()->inputs.emplace_back(blob.begin(), blob.end());
+    }
+    HashInputChunk(*chunks.back());
+  }  // The hashing threads join here.
+
+  std::vector<ByteArray> inputs;
+  std::vector<HashDigest> hashes;
+  for (auto &chunk : chunks) {
+    std::move(chunk->inputs.begin(), chunk->inputs.end(),
+              std::back_inserter(inputs));
+    std::move(chunk->hashes.begin(), chunk->hashes.end(),
+              std::back_inserter(hashes));
+  }
+  chunks.clear();
+
+  // Maps input hashes to the indices of the inputs, the first input last.
+  // NOTE: Identical inputs are all kept, each getting its own features
+  // record, if any.
   // TODO(ussuri): This is the legacy behavior. At least one test relies on
-  //  it (but doesn't really need it). Investigate and switch to
-  //  `absl::flat_hash_map`.
-  std::multimap<std::string /*hash*/, ByteArray /*input*/> hash_to_input;
-  // Read inputs from the corpus file into `hash_to_input`.
-  auto corpus_reader = DefaultBlobFileReaderFactory();
-  CHECK_OK(corpus_reader->Open(corpus_path)) << VV(corpus_path);
-  ByteSpan blob;
-  while (corpus_reader->Read(blob).ok()) {
-    std::string hash = Hash(blob);
-    ByteArray input{blob.begin(), blob.end()};
-    hash_to_input.emplace(std::move(hash), std::move(input));
+  //  it (but doesn't really need it). Investigate and deduplicate.
+  absl::flat_hash_map<HashDigest, absl::InlinedVector<size_t, 1>>
+      hash_to_inputs;
+  hash_to_inputs.reserve(inputs.size());
+  for (size_t i = inputs.size(); i > 0; --i) {
+    hash_to_inputs[hashes[i - 1]].push_back(i - 1);
   }
 
   RPROF_SNAPSHOT("Read inputs");
 
   // Input counts of various kinds (for logging).
-  const size_t num_inputs = hash_to_input.size();
+  const size_t num_inputs = inputs.size();
   size_t num_inputs_missing_features = num_inputs;
   size_t num_inputs_empty_features = 0;
   size_t num_inputs_non_empty_features = 0;
 
-  // If the features file is not passed or doesn't exist, simply ignore it.
-  if (!good_features_path) {
-    LOG(WARNING) << "Features file path empty or not found - ignoring: "
-                 << features_path;
-  } else {
-    // Read features from the features file. For each feature, find a matching
-    // input in `hash_to_input`, call `callback` for the pair, and remove the
-    // entry from `hash_to_input`. In the end, `hash_to_input` will contain
-    // only inputs without matching features.
+  // Stream the features file: for each record, find a matching input, call
+  // `callback` for the pair, and mark the input as reported. In the end, the
+  // unreported inputs are the ones without matching features.
+  std::vector<bool> reported(num_inputs);
+  if (good_features_path) {
     auto features_reader = DefaultBlobFileReaderFactory();
     CHECK_OK(features_reader->Open(features_path)) << VV(features_path);
     ByteSpan hash_and_features;
     while (features_reader->Read(hash_and_features).ok()) {
       // Every valid feature record must contain the hash at the end.
-      // Ignore this record if it is too short.
-      if (hash_and_features.size() < kHashLen) continue;
+      // Ignore this record if it is too short or the hash is not valid.
       FeatureVec features;
-      std::string hash = UnpackFeaturesAndHash(hash_and_features, &features);
-      auto input_node = hash_to_input.extract(hash);
-      if (!input_node.empty()) {
-        --num_inputs_missing_features;
-        if (features.empty()) {
-          // When the features file got created, Centipede did compute features
-          // for the input, but they came up empty. Indicate to the client that
-          // there is no need to recompute by passing this special value.
-          features = {feature_domains::kNoFeature};
-          ++num_inputs_empty_features;
-        } else {
-          ++num_inputs_non_empty_features;
-        }
-        callback(std::move(input_node.mapped()), std::move(features));
+      std::optional<HashDigest> hash =
+          UnpackFeaturesAndHashDigest(hash_and_features, &features);
+      if (!hash.has_value()) continue;
+      auto it = hash_to_inputs.find(*hash);
+      if (it == hash_to_inputs.end() || it->second.empty()) continue;
+      const size_t input_index = it->second.back();
+      it->second.pop_back();
+      reported[input_index] = true;
+      --num_inputs_missing_features;
+      if (features.empty()) {
+        // When the features file got created, Centipede did compute features
+        // for the input, but they came up empty. Indicate to the client that
+        // there is no need to recompute by passing this special value.
+        features = {feature_domains::kNoFeature};
+        ++num_inputs_empty_features;
+      } else {
+        ++num_inputs_non_empty_features;
       }
+      callback(std::move(inputs[input_index]), std::move(features));
     }
-
     RPROF_SNAPSHOT("Read features & reported input/features pairs");
   }
 
   // Finally, call `callback` on the remaining inputs without matching features.
   // This also automatically covers the features file not passed or missing.
-  for (auto &&[hash, input] : hash_to_input) {
+  for (size_t i = 0; i < num_inputs; ++i) {
+    if (reported[i]) continue;
     // Indicate to the client that it needs to recompute features for this input
     // by passing an empty value.
-    callback(std::move(input), {});
+    callback(std::move(inputs[i]), {});
   }
 
   RPROF_SNAPSHOT("Reported inputs with no matching features");
@@ -40,6 +40,12 @@ namespace centipede {
 //
 // If features are found for a given input but are empty,
 // then callback's 2nd argument is {feature_domains::kNoFeature}.
+//
+// The inputs are hashed on several threads while `corpus_path` is read. Then
+// `features_path` is streamed one record at a time, so it is never held in
+// memory whole. `callback` is called on the calling thread only: first for
+// the inputs with features, in the order of `features_path`, then for the
+// others, in the order of `corpus_path`.
 void ReadShard(std::string_view corpus_path, std::string_view features_path,
                const std::function<void(ByteArray, FeatureVec)> &callback);
 
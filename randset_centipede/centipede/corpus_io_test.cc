@@ -14,6 +14,8 @@
 
 #include "./centipede/corpus_io.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>  // NOLINT
 #include <string>
 #include <string_view>
@@ -106,6 +108,54 @@ TEST(ReadShardTest, ReadsInputsAndFeaturesAndCallsCallbackForEachPair) {
   EXPECT_EQ(res[4].features, FeatureVec());
 }
 
+TEST(ReadShardTest, MatchesFeaturesOfManyAndDuplicateInputs) {
+  // Enough inputs for several hashing chunks, every input twice.
+  constexpr size_t kNumInputs = 5000;
+  std::vector<ByteArray> corpus_blobs;
+  std::vector<ByteArray> features_blobs;
+  for (size_t i = 0; i < kNumInputs; ++i) {
+    const ByteArray input = {static_cast<uint8_t>(i),
+                             static_cast<uint8_t>(i >> 8)};
+    corpus_blobs.push_back(input);
+    corpus_blobs.push_back(input);
+    // Features for one copy of the even inputs only.
+    if (i % 2 == 0) {
+      features_blobs.push_back(PackFeaturesAndHash(input, {i + 1}));
+    }
+  }
+
+  TempDir tmp_dir{test_info_->name()};
+  std::string corpus_path = tmp_dir.GetFilePath("corpus");
+  std::string features_path = tmp_dir.GetFilePath("features");
+  WriteBlobsToFile(corpus_path, corpus_blobs);
+  WriteBlobsToFile(features_path, features_blobs);
+
+  std::vector<CorpusRecord> res;
+  ReadShard(corpus_path, features_path,
+            [&res](const ByteArray& input, const FeatureVec& features) {
+              res.push_back(CorpusRecord{input, features});
+            });
+
+  ASSERT_EQ(res.size(), corpus_blobs.size());
+  // First the inputs with features, in the order of the features file.
+  const size_t num_with_features = features_blobs.size();
+  for (size_t i = 0; i < num_with_features; ++i) {
+    EXPECT_EQ(res[i].data, corpus_blobs[4 * i]);
+    EXPECT_EQ(res[i].features, FeatureVec{2 * i + 1});
+  }
+  // Then the others, in the order of the corpus file.
+  std::vector<ByteArray> expected_without_features;
+  for (size_t i = 0; i < corpus_blobs.size(); ++i) {
+    if (i % 4 != 0) expected_without_features.push_back(corpus_blobs[i]);
+  }
+  std::vector<ByteArray> without_features;
+  for (size_t i = num_with_features; i < res.size(); ++i) {
+    EXPECT_EQ(res[i].features, FeatureVec());
+    without_features.push_back(res[i].data);
+  }
+  EXPECT_EQ(without_features, expected_without_features);
+}
+
 TEST(ExportCorpusTest, ExportsCorpusToIndividualFiles) {
   const std::filesystem::path temp_dir = GetTestTempDir(test_info_->name());
   const std::filesystem::path out_dir = temp_dir / "out_dir";
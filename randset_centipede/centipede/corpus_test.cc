@@ -28,6 +28,7 @@
 #include "./centipede/feature.h"
 #include "./centipede/feature_set.h"
 #include "./centipede/pc_info.h"
+#include "./centipede/test_binary_info_util.h"
 #include "./centipede/util.h"
 #include "./common/defs.h"
 #include "./common/test_util.h"
@@ -139,6 +140,74 @@ TEST(Corpus, Prune) {
   EXPECT_EQ(corpus.NumTotal(), 6);
 }
 
+// Adds and prunes records of `corpus`, checks their features.
+void CheckPruneCompactsFeatures(Corpus corpus) {
+  PCTable pc_table(100);
+  CFTable cf_table(100);
+  BinaryInfo bin_info{pc_table, {}, cf_table, {}, {}, {}};
+  CoverageFrontier coverage_frontier(bin_info);
+  FeatureSet fs(3, {});
+  Rng rng(0);
+  size_t max_corpus_size = 1000;
+  FeatureVec scratch;
+
+  auto Add = [&](const CorpusRecord &record) {
+    fs.IncrementFrequencies(record.features);
+    corpus.Add(record.data, record.features, {}, fs, coverage_frontier);
+  };
+  auto GetFeatures = [&](size_t idx) {
+    const auto features = corpus.GetFeatures(idx, scratch);
+    return FeatureVec(features.begin(), features.end());
+  };
+  auto VerifyFeatures = [&](const std::vector<CorpusRecord> &expected) {
+    ASSERT_EQ(corpus.NumActive(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(corpus.Get(i), expected[i].data);
+      EXPECT_EQ(GetFeatures(i), expected[i].features);
+    }
+  };
+
+  Add({{0}, {20, 40}});
+  Add({{1}, {20, 30}});
+  Add({{2}, {20, 50}});
+  // Feature 20 is frequent: pruned from every record, which all stay.
+  EXPECT_EQ(corpus.Prune(fs, coverage_frontier, max_corpus_size, rng), 0);
+  VerifyFeatures({{{0}, {40}}, {{1}, {30}}, {{2}, {50}}});
+
+  Add({{3}, {30, 60}});
+  Add({{4}, {30, 70}});
+  // Feature 30 is frequent: input {1} goes, the others move over it.
+  EXPECT_EQ(corpus.Prune(fs, coverage_frontier, max_corpus_size, rng), 1);
+  VerifyFeatures({{{0}, {40}}, {{2}, {50}}, {{3}, {60}}, {{4}, {70}}});
+  Add({{5}, {80}});
+  EXPECT_EQ(GetFeatures(4), FeatureVec({80}));
+}
+
+TEST(Corpus, PruneCompactsFeatures) { CheckPruneCompactsFeatures(Corpus()); }
+
+TEST(Corpus, PruneCompactsCompressedFeatures) {
+  CheckPruneCompactsFeatures(Corpus(/*compress_features=*/true));
+}
+
+TEST(Corpus, CompressedFeaturesAreSorted) {
+  PCTable pc_table(100);
+  CFTable cf_table(100);
+  BinaryInfo bin_info{pc_table, {}, cf_table, {}, {}, {}};
+  CoverageFrontier coverage_frontier(bin_info);
+  FeatureSet fs(3, {});
+  Corpus corpus(/*compress_features=*/true);
+  const FeatureVec features = {feature_domains::kCMP.ConvertToMe(5),
+                               feature_domains::kPCs.ConvertToMe(7), 3};
+  fs.IncrementFrequencies(features);
+  corpus.Add({1}, features, {}, fs, coverage_frontier);
+  FeatureVec scratch;
+  const auto decompressed = corpus.GetFeatures(0, scratch);
+  FeatureVec sorted_features = features;
+  std::sort(sorted_features.begin(), sorted_features.end());
+  EXPECT_EQ(FeatureVec(decompressed.begin(), decompressed.end()),
+            sorted_features);
+}
+
 // Regression test for a crash in Corpus::Prune().
 TEST(Corpus, PruneRegressionTest1) {
   PCTable pc_table(100);
@@ -254,6 +323,69 @@ TEST(WeightedDistribution, WeightedDistribution) {
   compute_freq();
 }
 
+TEST(WeightedSumTree, RandomIndexIsProportionalToWeights) {
+  WeightedSumTree tree;
+  // Every number in [0, total_weight()) picks the index whose weight range
+  // contains it, so the frequencies are exact.
+  auto expect_exact_freq = [&](const std::vector<uint64_t> &weights) {
+    ASSERT_EQ(tree.size(), weights.size());
+    uint64_t total_weight = 0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+      EXPECT_EQ(tree.weight(i), weights[i]);
+      total_weight += weights[i];
+    }
+    ASSERT_EQ(tree.total_weight(), total_weight);
+    std::vector<uint64_t> freq(weights.size());
+    for (uint64_t i = 0; i < 2 * total_weight; ++i) {
+      freq[tree.RandomIndex(i)]++;
+    }
+    for (size_t i = 0; i < weights.size(); ++i) {
+      EXPECT_EQ(freq[i], 2 * weights[i]) << i;
+    }
+  };
+
+  std::vector<uint64_t> weights = {1, 2, 3, 4, 5};
+  tree.Assign(weights);
+  expect_exact_freq(weights);
+
+  // Decreasing and increasing weights, including to and from 0.
+  weights = {1, 0, 3, 10, 5};
+  tree.SetWeight(1, 0);
+  tree.SetWeight(3, 10);
+  expect_exact_freq(weights);
+  weights = {0, 7, 3, 10, 0};
+  tree.SetWeight(0, 0);
+  tree.SetWeight(1, 7);
+  tree.SetWeight(4, 0);
+  expect_exact_freq(weights);
+
+  // Sizes that are not powers of 2, with zeros at the ends.
+  for (size_t size = 1; size <= 17; ++size) {
+    weights.assign(size, 0);
+    for (size_t i = 1; i + 1 < size; ++i) weights[i] = i % 3;
+    weights[size / 2] = 1;
+    tree.Assign(weights);
+    expect_exact_freq(weights);
+  }
+
+  // Picking without replacement visits every non-zero index once.
+  weights.clear();
+  for (uint64_t i = 0; i < 1000; ++i) weights.push_back(i % 7);
+  tree.Assign(weights);
+  Rng rng(1);
+  std::vector<bool> picked(weights.size());
+  while (tree.total_weight() != 0) {
+    const size_t idx = tree.RandomIndex(rng());
+    EXPECT_FALSE(picked[idx]);
+    EXPECT_NE(weights[idx], 0);
+    picked[idx] = true;
+    tree.SetWeight(idx, 0);
+  }
+  for (size_t i = 0; i < weights.size(); ++i) {
+    EXPECT_EQ(picked[i], weights[i] != 0) << i;
+  }
+}
+
 // TODO(ussuri): This is becoming difficult to maintain: various bits of the
 //  input data are stored in independent arrays, other bits are dynamically
 //  initialized, and the matching expected results are listed in two long chains
@@ -380,6 +512,133 @@ TEST(CoverageFrontier, Compute) {
   EXPECT_EQ(frontier.FrontierWeight(16), 0);
   EXPECT_EQ(frontier.FrontierWeight(17), 0);
   EXPECT_EQ(frontier.FrontierWeight(18), 0);
+
+  // The same coverage added incrementally, in a different order and with
+  // weight updates in between, yields the same frontier and weights.
+  CoverageFrontier incremental(bin_info);
+  for (size_t idx : {17, 16, 14, 13, 12, 11, 10, 9, 7, 6, 2, 0}) {
+    incremental.AddCoverage({pcs[idx]});
+    incremental.UpdateFrontierWeights();
+  }
+  EXPECT_EQ(incremental.NumFunctionsInFrontier(), 3);
+  for (size_t i = 0; i < pc_table.size(); i++) {
+    EXPECT_EQ(incremental.PcIndexIsFrontier(i), frontier.PcIndexIsFrontier(i))
+        << i;
+    EXPECT_EQ(incremental.FrontierWeight(i), frontier.FrontierWeight(i)) << i;
+  }
+}
+
+TEST(CoverageFrontier, ParallelWeightsMatchSequential) {
+  // Bb 1 calls the next function, bb 2 a pseudo-random one, bb 3 makes an
+  // indirect call. With 4 PCs per function, that is 4 threads' worth of PCs.
+  constexpr size_t kNumFunctions = CoverageFrontier::kMinPcsPerWeightThread;
+  const BinaryInfo bin_info =
+      DiamondFunctions(kNumFunctions, DiamondCalls::kNextRandomAndIndirect);
+
+  // Cover bbs 0 and 1 of every function, and every third function fully.
+  std::vector<CorpusRecord> records(1);
+  for (size_t f = 0; f < kNumFunctions; ++f) {
+    for (size_t bb = 0; bb < 4; ++bb) {
+      if (bb < 2 || f % 3 == 0) {
+        records[0].features.push_back(
+            feature_domains::kPCs.ConvertToMe(4 * f + bb));
+      }
+    }
+  }
+
+  CoverageFrontier sequential(bin_info);
+  CoverageFrontier parallel(bin_info);
+  EXPECT_EQ(sequential.Compute(records, /*num_threads=*/1),
+            parallel.Compute(records, /*num_threads=*/4));
+  size_t num_weighted = 0;
+  for (size_t i = 0; i < bin_info.pc_table.size(); ++i) {
+    EXPECT_EQ(parallel.PcIndexIsFrontier(i), sequential.PcIndexIsFrontier(i))
+        << i;
+    EXPECT_EQ(parallel.FrontierWeight(i), sequential.FrontierWeight(i)) << i;
+    if (sequential.FrontierWeight(i) != 0) ++num_weighted;
+  }
+  // Bbs 0 and 1 of every partially covered function.
+  EXPECT_EQ(num_weighted, 2 * (kNumFunctions - (kNumFunctions + 2) / 3));
+}
+
+TEST(CoverageFrontier, AddCoverage) {
+  // One function, a diamond: 1 -> {2, 3} -> 4.
+  const BinaryInfo bin_info = DiamondFunctions(1, DiamondCalls::kNone);
+  CoverageFrontier frontier(bin_info);
+
+  auto pc = [](size_t idx) { return feature_domains::kPCs.ConvertToMe(idx); };
+  auto frontier_pcs = [&] {
+    std::vector<size_t> res;
+    for (size_t i = 0; i < bin_info.pc_table.size(); ++i) {
+      if (frontier.PcIndexIsGlobalFrontier(i)) res.push_back(i);
+    }
+    EXPECT_EQ(res.size(), frontier.NumGlobalFrontierNodes());
+    return res;
+  };
+
+  EXPECT_EQ(frontier_pcs(), std::vector<size_t>{});
+  frontier.AddCoverage({pc(0), feature_domains::kUnknown.ConvertToMe(1)});
+  EXPECT_EQ(frontier_pcs(), std::vector<size_t>({0}));
+  frontier.AddCoverage({pc(1)});
+  EXPECT_EQ(frontier_pcs(), std::vector<size_t>({0, 1}));
+  frontier.AddCoverage({pc(2), pc(1)});
+  EXPECT_EQ(frontier_pcs(), std::vector<size_t>({1, 2}));
+  frontier.AddCoverage({pc(3)});
+  EXPECT_EQ(frontier_pcs(), std::vector<size_t>{});
+
+  // Recomputing from scratch forgets the coverage added above.
+  std::vector<CorpusRecord> records(2);
+  records[0].features = {pc(0)};
+  records[1].features = {pc(2)};
+  frontier.UpdateGlobalFrontierSet(records);
+  EXPECT_EQ(frontier_pcs(), std::vector<size_t>({0, 2}));
+}
+
+TEST(Corpus, UpdateFrontierNodeSetForCorpus) {
+  // One function, a diamond: 1 -> {2, 3} -> 4.
+  const BinaryInfo bin_info = DiamondFunctions(1, DiamondCalls::kNone);
+  CoverageFrontier frontier(bin_info);
+  FeatureSet fs(100, {});
+  Corpus corpus;
+
+  auto pc = [](size_t idx) { return feature_domains::kPCs.ConvertToMe(idx); };
+  auto Add = [&](const FeatureVec &fv) {
+    fs.IncrementFrequencies(fv);
+    frontier.AddCoverage(fv);
+    corpus.Add({42}, fv, {}, fs, frontier);
+  };
+
+  Add({pc(1), pc(0)});
+  EXPECT_EQ(corpus.GetFrontierNodeSet(0), PCIndexVec({0, 1}));
+  Add({pc(2)});
+  // Not updated yet.
+  EXPECT_EQ(corpus.GetFrontierNodeSet(0), PCIndexVec({0, 1}));
+  EXPECT_EQ(corpus.GetFrontierNodeSet(1), PCIndexVec({2}));
+  EXPECT_TRUE(frontier.HasGlobalFrontierChanges());
+  EXPECT_EQ(corpus.RecordsWithPc(1), std::vector<uint32_t>({0}));
+  EXPECT_EQ(corpus.RecordsWithPc(2), std::vector<uint32_t>({1}));
+  EXPECT_TRUE(corpus.RecordsWithPc(3).empty());
+  corpus.UpdateFrontierNodeSetForCorpus(frontier);
+  frontier.ClearGlobalFrontierChanges();
+  EXPECT_FALSE(frontier.HasGlobalFrontierChanges());
+  EXPECT_EQ(corpus.GetFrontierNodeSet(0), PCIndexVec({1}));
+  EXPECT_EQ(corpus.GetFrontierNodeSet(1), PCIndexVec({2}));
+
+  Add({pc(3)});
+  EXPECT_EQ(frontier.GlobalFrontierChanges(), PCIndexVec({1, 2}));
+  corpus.UpdateFrontierNodeSetForCorpus(frontier);
+  frontier.ClearGlobalFrontierChanges();
+  for (size_t i = 0; i < corpus.NumActive(); ++i) {
+    EXPECT_TRUE(corpus.GetFrontierNodeSet(i).empty());
+  }
+
+  // A full recomputation rebuilds every record.
+  frontier.UpdateGlobalFrontierSet({{corpus.Get(0), {pc(1), pc(0)}}});
+  EXPECT_TRUE(frontier.GlobalFrontierWasReset());
+  corpus.UpdateFrontierNodeSetForCorpus(frontier);
+  EXPECT_EQ(corpus.GetFrontierNodeSet(0), PCIndexVec({0, 1}));
+  EXPECT_EQ(corpus.GetFrontierNodeSet(1), PCIndexVec{});
+  EXPECT_EQ(corpus.GetFrontierNodeSet(2), PCIndexVec{});
 }
 
 TEST(CoverageFrontierDeath, InvalidIndexToFrontier) {
@@ -26,6 +26,7 @@
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/synchronization/mutex.h"
 #include "./centipede/control_flow.h"
@@ -180,6 +181,14 @@ uint32_t ComputeFrontierWeight(const Coverage &coverage,
                                const ControlFlowGraph &cfg,
                                const std::vector<uintptr_t> &callees);
 
+// Same as above, but takes the coverage of the callees as predicates on
+// pc_table indices, for callers that do not keep a `Coverage` object.
+// `function_is_fully_covered` is only called for function entries.
+uint32_t ComputeFrontierWeight(
+    const ControlFlowGraph &cfg, const std::vector<uintptr_t> &callees,
+    absl::FunctionRef<bool(PCIndex)> block_is_covered,
+    absl::FunctionRef<bool(PCIndex)> function_is_fully_covered);
+
 }  // namespace centipede
 
 #endif  // THIRD_PARTY_CENTIPEDE_COVERAGE_H_
@@ -29,6 +29,7 @@
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
@@ -36,6 +37,9 @@
 #include "absl/strings/str_join.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "./centipede/binary_info.h"
+#include "./centipede/control_flow.h"
+#include "./centipede/corpus.h"
 #include "./centipede/corpus_io.h"
 #include "./centipede/environment.h"
 #include "./centipede/feature.h"
@@ -44,6 +48,7 @@
 #include "./centipede/resource_pool.h"
 #include "./centipede/rusage_profiler.h"
 #include "./centipede/rusage_stats.h"
+#include "./centipede/shared_coverage_frontier.h"
 #include "./centipede/thread_pool.h"
 #include "./centipede/util.h"
 #include "./centipede/workdir.h"
@@ -165,11 +170,18 @@ class CorpusShardWriter {
     size_t num_written_batches = 0;
   };
 
+  // Writes to the distilled corpus and features shards of `env`.
   CorpusShardWriter(const Environment &env, bool append)
-      : workdir_{env},
-        log_prefix_{LogPrefix(env)},
-        corpus_path_{workdir_.DistilledCorpusFilePaths().MyShard()},
-        features_path_{workdir_.DistilledFeaturesFilePaths().MyShard()},
+      : CorpusShardWriter{
+            env, WorkDir{env}.DistilledCorpusFilePaths().MyShard(),
+            WorkDir{env}.DistilledFeaturesFilePaths().MyShard(), append} {}
+
+  // Writes to `corpus_path` and `features_path`.
+  CorpusShardWriter(const Environment &env, std::string_view corpus_path,
+                    std::string_view features_path, bool append)
+      : log_prefix_{LogPrefix(env)},
+        corpus_path_{corpus_path},
+        features_path_{features_path},
         corpus_writer_{DefaultBlobFileWriterFactory()},
         feature_writer_{DefaultBlobFileWriterFactory()} {
     CHECK_OK(corpus_writer_->Open(corpus_path_, append ? "a" : "w"));
@@ -222,7 +234,6 @@ class CorpusShardWriter {
   }
 
   // Const state.
-  const WorkDir workdir_;
   const std::string log_prefix_;
   const std::string corpus_path_;
   const std::string features_path_;
@@ -274,8 +285,7 @@ class DistillingInputFilter {
 
     // Filter out approximately byte-identical inputs ("approximately" because
     // we use hashes).
-    std::string hash = Hash(elt.input);
-    const auto [iter, inserted] = seen_inputs_.insert(std::move(hash));
+    const auto [iter, inserted] = seen_inputs_.insert(HashDigestOf(elt.input));
     if (!inserted) return std::nullopt;
     ++stats_.num_byte_unique_elts;
 
@@ -298,7 +308,7 @@ class DistillingInputFilter {
 
  private:
   absl::Mutex mu_;
-  absl::flat_hash_set<std::string /*hash*/> seen_inputs_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_set<HashDigest> seen_inputs_ ABSL_GUARDED_BY(mu_);
   FeatureSet seen_features_ ABSL_GUARDED_BY(mu_);
   Stats stats_ ABSL_GUARDED_BY(mu_);
 };
@@ -457,6 +467,251 @@ int Distill(const Environment &env, const DistillOptions &opts) {
   return EXIT_SUCCESS;
 }
 
+namespace {
+
+// Reads the shards `shard_indices` with up to `parallelism` concurrent threads,
+// each gated on leasing enough RAM from `ram_pool`, and calls
+// `callback(shard_idx, shard_elts)` for every shard, concurrently.
+void ForEachShardInParallel(
+    const Environment &env, const std::vector<size_t> &shard_indices,
+    perf::ResourcePool<perf::RUsageMemory> &ram_pool, int parallelism,
+    std::string_view lease_prefix,
+    const std::function<void(size_t shard_idx, CorpusEltVec shard_elts)>
+        &callback) {
+  InputCorpusShardReader reader{env};
+  ThreadPool threads{parallelism};
+  for (size_t shard_idx : shard_indices) {
+    threads.Schedule([shard_idx, &reader, &ram_pool, lease_prefix, &callback] {
+      const auto ram_lease = ram_pool.AcquireLeaseBlocking({
+          /*id=*/absl::StrCat(lease_prefix, "/in_", shard_idx),
+          /*amount=*/
+          {/*mem_vsize=*/0, /*mem_vpeak=*/0,
+           /*mem_rss=*/reader.EstimateRamFootprint(shard_idx)},
+          /*timeout=*/kRamLeaseTimeout,
+      });
+      CHECK_OK(ram_lease.status());
+      callback(shard_idx, reader.ReadShard(shard_idx));
+    });
+  }
+  // The threads join when `threads` goes out of scope.
+}
+
+// Returns the sorted PC indices of the PC features in `features`.
+PCIndexVec PcIndicesOf(const FeatureVec &features) {
+  PCIndexVec pcs;
+  for (const feature_t feature : features) {
+    if (!feature_domains::kPCs.Contains(feature)) continue;
+    pcs.push_back(ConvertPCFeatureToPcIndex(feature));
+  }
+  std::sort(pcs.begin(), pcs.end());
+  pcs.erase(std::unique(pcs.begin(), pcs.end()), pcs.end());
+  return pcs;
+}
+
+// Returns `num_covers` randomized covers of the PCs in `elt_pcs`, where
+// `elt_pcs[i]` are the sorted PCs of element `i`. Every cover is a sorted list
+// of element indices such that every PC of every element is had by some
+// element of the cover, and that has no redundant element. Every cover visits
+// the PCs in a random order and, for every PC not covered yet, picks a random
+// element having it, among those picked by the fewest earlier covers.
+std::vector<std::vector<size_t>> RandomizedMinimalCovers(
+    std::vector<PCIndexVec> elt_pcs, size_t num_covers, Rng &rng) {
+  // Replace the PCs by dense ids.
+  PCIndexVec universe;
+  for (const auto &pcs : elt_pcs) {
+    universe.insert(universe.end(), pcs.begin(), pcs.end());
+  }
+  std::sort(universe.begin(), universe.end());
+  universe.erase(std::unique(universe.begin(), universe.end()),
+                 universe.end());
+  for (auto &pcs : elt_pcs) {
+    for (auto &pc : pcs) {
+      pc = std::lower_bound(universe.begin(), universe.end(), pc) -
+           universe.begin();
+    }
+  }
+
+  // elts_with_pc[offsets[id], offsets[id + 1]) are the elements having PC id.
+  std::vector<size_t> offsets(universe.size() + 1, 0);
+  for (const auto &pcs : elt_pcs) {
+    for (const PCIndex id : pcs) ++offsets[id + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<size_t> elts_with_pc(offsets.back());
+  {
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t elt = 0; elt < elt_pcs.size(); ++elt) {
+      for (const PCIndex id : elt_pcs[elt]) elts_with_pc[next[id]++] = elt;
+    }
+  }
+
+  std::vector<std::vector<size_t>> covers(num_covers);
+  std::vector<size_t> times_picked(elt_pcs.size(), 0);
+  std::vector<size_t> num_covering(universe.size());
+  std::vector<size_t> order(universe.size());
+  for (auto &cover : covers) {
+    std::fill(num_covering.begin(), num_covering.end(), 0);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    for (const size_t id : order) {
+      if (num_covering[id] != 0) continue;
+      size_t min_picked = SIZE_MAX;
+      for (size_t i = offsets[id]; i < offsets[id + 1]; ++i) {
+        min_picked = std::min(min_picked, times_picked[elts_with_pc[i]]);
+      }
+      // Reservoir-sample one of the least picked elements.
+      size_t num_least_picked = 0;
+      size_t picked = 0;
+      for (size_t i = offsets[id]; i < offsets[id + 1]; ++i) {
+        const size_t elt = elts_with_pc[i];
+        if (times_picked[elt] != min_picked) continue;
+        if (rng() % ++num_least_picked == 0) picked = elt;
+      }
+      cover.push_back(picked);
+      for (const PCIndex pc : elt_pcs[picked]) ++num_covering[pc];
+    }
+    // Drop the redundant elements, in a random order, to make the cover
+    // minimal.
+    std::shuffle(cover.begin(), cover.end(), rng);
+    cover.erase(std::remove_if(cover.begin(), cover.end(),
+                               [&](size_t elt) {
+                                 for (const PCIndex pc : elt_pcs[elt]) {
+                                   if (num_covering[pc] == 1) return false;
+                                 }
+                                 for (const PCIndex pc : elt_pcs[elt]) {
+                                   --num_covering[pc];
+                                 }
+                                 return true;
+                               }),
+                cover.end());
+    for (const size_t elt : cover) ++times_picked[elt];
+    std::sort(cover.begin(), cover.end());
+  }
+  return covers;
+}
+
+}  // namespace
+
+int DistillFrontierCovers(const Environment &env,
+                          const BinaryInfo &binary_info) {
+  RPROF_THIS_FUNCTION_WITH_TIMELAPSE(                                      //
+      /*enable=*/ABSL_VLOG_IS_ON(1),                                       //
+      /*timelapse_interval=*/absl::Seconds(ABSL_VLOG_IS_ON(2) ? 10 : 60),  //
+      /*also_log_timelapses=*/ABSL_VLOG_IS_ON(10));
+  CHECK_GT(env.distill_frontier_covers, 0);
+
+  std::vector<size_t> all_shard_indices(env.total_shards);
+  std::iota(all_shard_indices.begin(), all_shard_indices.end(), 0);
+  perf::ResourcePool ram_pool{kRamQuota};
+
+  // Read the PCs of all inputs and compute the frontier. Of byte-identical
+  // inputs, the one in the lowest (shard, position) is kept, independently of
+  // the order in which the shards are read.
+  SharedCoverageFrontier coverage_frontier{binary_info};
+  std::vector<std::vector<PCIndexVec>> shard_elt_pcs(env.total_shards);
+  absl::Mutex mu;
+  absl::flat_hash_map<HashDigest, std::pair<size_t, size_t>>
+      first_input_with_hash;
+  LOG(INFO) << LogPrefix() << "Reading " << env.total_shards
+            << " shards to compute the frontier";
+  ForEachShardInParallel(
+      env, all_shard_indices, ram_pool, kMaxReadingThreads, "frontier",
+      [&](size_t shard_idx, CorpusEltVec shard_elts) {
+        std::vector<PCIndexVec> elt_pcs(shard_elts.size());
+        for (size_t i = 0; i < shard_elts.size(); ++i) {
+          coverage_frontier.AddCoverage(shard_elts[i].features);
+          elt_pcs[i] = PcIndicesOf(shard_elts[i].features);
+          const std::pair<size_t, size_t> position{shard_idx, i};
+          const HashDigest hash = HashDigestOf(shard_elts[i].input);
+          absl::MutexLock lock(&mu);
+          auto [it, inserted] =
+              first_input_with_hash.try_emplace(hash, position);
+          if (!inserted) it->second = std::min(it->second, position);
+        }
+        absl::MutexLock lock(&mu);
+        shard_elt_pcs[shard_idx] = std::move(elt_pcs);
+      });
+
+  // Number the inputs in the (shard, position) order, keep only their
+  // frontier PCs (or all PCs, if there is no frontier) and drop duplicates.
+  std::vector<size_t> shard_offsets(env.total_shards + 1, 0);
+  for (size_t shard_idx = 0; shard_idx < env.total_shards; ++shard_idx) {
+    shard_offsets[shard_idx + 1] =
+        shard_offsets[shard_idx] + shard_elt_pcs[shard_idx].size();
+  }
+  std::vector<PCIndexVec> elt_pcs(shard_offsets.back());
+  for (size_t shard_idx = 0; shard_idx < env.total_shards; ++shard_idx) {
+    std::move(shard_elt_pcs[shard_idx].begin(),
+              shard_elt_pcs[shard_idx].end(),
+              elt_pcs.begin() + shard_offsets[shard_idx]);
+  }
+  shard_elt_pcs.clear();
+  std::vector<bool> is_first_with_hash(elt_pcs.size(), false);
+  for (const auto &[hash, position] : first_input_with_hash) {
+    is_first_with_hash[shard_offsets[position.first] + position.second] = true;
+  }
+  first_input_with_hash.clear();
+  const size_t num_frontier_pcs = coverage_frontier.NumGlobalFrontierNodes();
+  coverage_frontier.Read([&](const CoverageFrontier &frontier) {
+    for (size_t elt = 0; elt < elt_pcs.size(); ++elt) {
+      PCIndexVec &pcs = elt_pcs[elt];
+      if (!is_first_with_hash[elt]) {
+        pcs.clear();
+      } else if (num_frontier_pcs != 0) {
+        pcs.erase(std::remove_if(pcs.begin(), pcs.end(),
+                                 [&](PCIndex pc) {
+                                   return pc >= binary_info.pc_table.size() ||
+                                          !frontier.PcIndexIsGlobalFrontier(pc);
+                                 }),
+                  pcs.end());
+      }
+    }
+  });
+  if (num_frontier_pcs == 0) {
+    LOG(WARNING) << LogPrefix() << "No coverage frontier; covering all PCs";
+  }
+
+  Rng rng{GetRandomSeed(env.seed)};
+  const std::vector<std::vector<size_t>> covers = RandomizedMinimalCovers(
+      std::move(elt_pcs), env.distill_frontier_covers, rng);
+  std::vector<std::vector<bool>> in_cover(
+      covers.size(), std::vector<bool>(shard_offsets.back(), false));
+  for (size_t k = 0; k < covers.size(); ++k) {
+    for (const size_t elt : covers[k]) in_cover[k][elt] = true;
+    LOG(INFO) << LogPrefix() << "Cover " << k << ": " << covers[k].size()
+              << " inputs for " << num_frontier_pcs << " frontier PCs";
+  }
+
+  // Re-read the shards and write every cover to its own output shard.
+  const WorkDir workdir{env};
+  std::vector<std::unique_ptr<CorpusShardWriter>> writers;
+  writers.reserve(covers.size());
+  for (size_t k = 0; k < covers.size(); ++k) {
+    // NOTE: Always overwrite corpus and features files, never append.
+    writers.push_back(std::make_unique<CorpusShardWriter>(
+        env, workdir.DistilledCoverCorpusFilePaths(k).MyShard(),
+        workdir.DistilledCoverFeaturesFilePaths(k).MyShard(),
+        /*append=*/false));
+  }
+  ForEachShardInParallel(
+      env, all_shard_indices, ram_pool, kMaxReadingThreads, "covers",
+      [&](size_t shard_idx, CorpusEltVec shard_elts) {
+        for (size_t k = 0; k < covers.size(); ++k) {
+          CorpusEltVec cover_elts;
+          for (size_t i = 0; i < shard_elts.size(); ++i) {
+            if (!in_cover[k][shard_offsets[shard_idx] + i]) continue;
+            cover_elts.emplace_back(shard_elts[i].input,
+                                    shard_elts[i].features);
+          }
+          writers[k]->WriteBatch(std::move(cover_elts));
+        }
+      });
+
+  LOG(INFO) << LogPrefix() << "Done distilling " << covers.size()
+            << " frontier covers";
+  return EXIT_SUCCESS;
+}
+
 void DistillForTests(const Environment &env,
                      const std::vector<size_t> &shard_indices) {
   DistillingInputFilter input_filter{
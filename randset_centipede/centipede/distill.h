@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "./centipede/binary_info.h"
 #include "./centipede/environment.h"
 
 namespace centipede {
@@ -40,6 +41,22 @@ struct DistillOptions {
 // Returns EXIT_SUCCESS.
 int Distill(const Environment &env, const DistillOptions &opts = {});
 
+// Reads `env.total_shards` input shards like `Distill()`, computes the coverage
+// frontier of `binary_info` over all of them, and writes
+// `env.distill_frontier_covers` randomized minimal covers of the frontier: the
+// k-th cover goes to shard `env.my_shard_index` of
+// `WorkDir::DistilledCoverCorpusFilePaths(k)`. Every
+// cover has, for every frontier PC, some input covering that PC, and no input
+// can be dropped from it without losing a frontier PC. The covers prefer
+// different inputs from each other, so that they make diverse seed corpora.
+// Byte-identical inputs are deduplicated. If `binary_info` yields no frontier
+// (e.g. it has no CF table), covers the covered PCs instead.
+//
+// The results are deterministic for a given non-zero `env.seed`.
+//
+// Returns EXIT_SUCCESS.
+int DistillFrontierCovers(const Environment &env, const BinaryInfo &binary_info);
+
 // Same as `Distill()`, but runs distillation without I/O parallelization and
 // reads shards in the order specified by `shard_indices` for deterministic
 // results.
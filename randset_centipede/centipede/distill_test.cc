@@ -16,6 +16,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <filesystem>  // NOLINT
 #include <string>
 #include <string_view>
@@ -26,9 +27,11 @@
 #include "gtest/gtest.h"
 #include "absl/flags/reflection.h"
 #include "absl/log/check.h"
+#include "./centipede/binary_info.h"
 #include "./centipede/corpus_io.h"
 #include "./centipede/environment.h"
 #include "./centipede/feature.h"
+#include "./centipede/test_binary_info_util.h"
 #include "./centipede/util.h"
 #include "./centipede/workdir.h"
 #include "./common/blob_file.h"
@@ -93,15 +96,10 @@ std::vector<TestCorpusRecord> ReadFromDistilled(const WorkDir &wd) {
   return result;
 }
 
-// Distills `shards` in the order specified by `shard_indices`,
-// returns the distilled corpus as a vector of inputs.
-std::vector<TestCorpusRecord> TestDistill(
-    const ShardVec &shards, const std::vector<size_t> &shard_indices,
-    std::string_view test_name, uint64_t user_feature_domain_mask) {
-  // Set up the environment.
-  // We need to set at least --binary_hash before `env` is constructed,
-  // so we do this by overriding the flags.
-  absl::FlagSaver flag_saver;
+// Returns the environment of a fresh workdir for `test_name`, with `shards`
+// written to it.
+Environment PrepareTestWorkdir(const ShardVec &shards,
+                               std::string_view test_name) {
   std::string dir = GetTestTempDir(test_name);
   std::filesystem::remove_all(dir);
   std::filesystem::create_directories(dir);
@@ -111,9 +109,7 @@ std::vector<TestCorpusRecord> TestDistill(
   env.binary_hash = "01234567890";
   env.total_shards = shards.size();
   env.my_shard_index = 1;  // an arbitrary shard index.
-  env.user_feature_domain_mask = user_feature_domain_mask;
-  const WorkDir wd{env};
-  std::filesystem::create_directories(wd.CoverageDirPath());
+  std::filesystem::create_directories(WorkDir{env}.CoverageDirPath());
 
   // Write the shards.
   for (size_t shard_index = 0; shard_index < shards.size(); ++shard_index) {
@@ -121,10 +117,24 @@ std::vector<TestCorpusRecord> TestDistill(
       WriteToShard(env, record, shard_index);
     }
   }
+  return env;
+}
+
+// Distills `shards` in the order specified by `shard_indices`,
+// returns the distilled corpus as a vector of inputs.
+std::vector<TestCorpusRecord> TestDistill(
+    const ShardVec &shards, const std::vector<size_t> &shard_indices,
+    std::string_view test_name, uint64_t user_feature_domain_mask) {
+  // Set up the environment.
+  // We need to set at least --binary_hash before `env` is constructed,
+  // so we do this by overriding the flags.
+  absl::FlagSaver flag_saver;
+  Environment env = PrepareTestWorkdir(shards, test_name);
+  env.user_feature_domain_mask = user_feature_domain_mask;
   // Distill.
   DistillForTests(env, shard_indices);
   // Read the result back.
-  return ReadFromDistilled(wd);
+  return ReadFromDistilled(WorkDir{env});
 }
 
 TEST(Distill, BasicDistill) {
@@ -187,6 +197,53 @@ TEST(Distill, BasicDistill) {
               }));
 }
 
+TEST(Distill, FrontierCovers) {
+  // One diamond function: bb 0 branches to bbs 1 and 2 that join in bb 3.
+  const BinaryInfo binary_info = DiamondFunctions(1, DiamondCalls::kNone);
+
+  auto pc = [](size_t pc_index) {
+    return feature_domains::kPCs.ConvertToMe(pc_index);
+  };
+  ByteArray in0 = {0};
+  ByteArray in1 = {1};
+  ByteArray in2 = {2};
+  ByteArray in3 = {3};
+  // Bbs 0 and 1 are covered and form the frontier. Only in0 and in1 cover
+  // both, and a duplicate of in0 must not count as a different input.
+  ShardVec shards = {
+      {
+          {in0, {pc(0), pc(1)}},
+          {in2, {pc(0), 10}},
+      },
+      {
+          {in1, {pc(0), pc(1)}},
+          {in3, {20}},
+          {in0, {pc(0), pc(1)}},
+      },
+  };
+
+  absl::FlagSaver flag_saver;
+  Environment env = PrepareTestWorkdir(shards, test_info_->name());
+  env.seed = 1;
+  env.distill_frontier_covers = 2;
+  EXPECT_EQ(DistillFrontierCovers(env, binary_info), EXIT_SUCCESS);
+
+  std::vector<ByteArray> cover_inputs;
+  const WorkDir workdir{env};
+  for (size_t k = 0; k < env.distill_frontier_covers; ++k) {
+    std::vector<TestCorpusRecord> cover;
+    ReadShard(workdir.DistilledCoverCorpusFilePaths(k).MyShard(),
+              workdir.DistilledCoverFeaturesFilePaths(k).MyShard(),
+              [&cover](ByteArray input, FeatureVec features) {
+                cover.push_back({std::move(input), std::move(features)});
+              });
+    ASSERT_EQ(cover.size(), 1);
+    cover_inputs.push_back(cover.front().input);
+  }
+  // Both covers are minimal, and diverse.
+  EXPECT_THAT(cover_inputs, UnorderedElementsAreArray({in0, in1}));
+}
+
 // TODO(kcc): add more tests once we settle on the testing code above.
 
 }  // namespace
@@ -143,6 +143,12 @@ void Environment::SetFlagForExperiment(std::string_view name,
       {"use_counter_features", &use_counter_features},
       {"use_pcpair_features", &use_pcpair_features},
       {"use_coverage_frontier", &use_coverage_frontier},
+      {"reset_frontier_selection_when_exhausted",
+       &reset_frontier_selection_when_exhausted},
+      {"weighted_first_mover_selection", &weighted_first_mover_selection},
+      {"frontier_mutation_budget", &frontier_mutation_budget},
+      {"pipelined_execution", &pipelined_execution},
+      {"compress_corpus_features", &compress_corpus_features},
       {"use_legacy_default_mutator", &use_legacy_default_mutator},
   };
   auto bool_iter = bool_flags.find(name);
@@ -159,6 +165,8 @@ void Environment::SetFlagForExperiment(std::string_view name,
       {"max_len", &max_len},
       {"crossover_level", &crossover_level},
       {"mutate_batch_size", &mutate_batch_size},
+      {"frontier_selection_window", &frontier_selection_window},
+      {"frontier_threads", &frontier_threads},
       {"feature_frequency_threshold", &feature_frequency_threshold},
   };
   auto int_iter = int_flags.find(name);
@@ -70,10 +70,18 @@ struct Environment {
   bool ignore_timeout_reports = false;
   absl::Time stop_at = absl::InfiniteFuture();
   bool fork_server = true;
+  size_t fork_server_persistent_batches = 0;
+  bool pipelined_execution = false;
   bool full_sync = false;
   bool use_corpus_weights = true;
   bool use_coverage_frontier = false;
+  size_t frontier_selection_window = 64;
+  bool reset_frontier_selection_when_exhausted = true;
+  bool weighted_first_mover_selection = false;
+  bool frontier_mutation_budget = false;
+  size_t frontier_threads = 1;
   size_t max_corpus_size = 100000;
+  bool compress_corpus_features = false;
   size_t crossover_level = 50;
   bool use_pc_features = true;
   size_t path_level = 0;
@@ -89,6 +97,7 @@ struct Environment {
   int telemetry_frequency = 0;
   bool print_runner_log = false;
   bool distill = false;
+  size_t distill_frontier_covers = 0;
   size_t log_features_shards = 0;
   std::string knobs_file;
   std::string corpus_to_files;
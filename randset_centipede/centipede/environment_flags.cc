@@ -179,6 +179,23 @@ ABSL_FLAG(bool, fork_server, Environment::Default().fork_server,
           "'%f' to disable the fork server. --fork_server applies to binaries "
           "passed via these flags: --binary, --extra_binaries, "
           "--input_filter.");
+ABSL_FLAG(size_t, fork_server_persistent_batches,
+          Environment::Default().fork_server_persistent_batches,
+          "If > 1, with --fork_server, a runner forked by the fork server "
+          "executes up to this many batches, one after another, before "
+          "exiting, instead of a fresh fork for every batch. The runner exits "
+          "earlier on the first failing batch. State left behind by one batch "
+          "in the target is seen by the next batches, and leaks are only "
+          "detected when the runner exits.");
+ABSL_FLAG(bool, pipelined_execution,
+          Environment::Default().pipelined_execution,
+          "If true, while the target executes a batch, mutates the next batch "
+          "and adds the results of the previous batch to the corpus, using a "
+          "second set of shared memory buffers. Hides the engine's work "
+          "behind the target's, but every batch is mutated without knowing "
+          "the results of the batch executed just before it. Mutations via "
+          "the target's custom mutator then use a separate fork server. "
+          "Inputs rerun when loading the corpus are pipelined the same way.");
 ABSL_FLAG(bool, full_sync, Environment::Default().full_sync,
           "Perform a full corpus sync on startup. If true, feature sets and "
           "corpora are read from all shards before fuzzing. This way fuzzing "
@@ -192,9 +209,41 @@ ABSL_FLAG(bool, use_coverage_frontier,
           Environment::Default().use_coverage_frontier,
           "If true, use coverage frontier when choosing the corpus element to "
           "mutate. This flag is mostly for Centipede developers.");
+ABSL_FLAG(size_t, frontier_selection_window,
+          Environment::Default().frontier_selection_window,
+          "A frontier PC picked by the seed selection is considered explored "
+          "for this many batches, after which its seeds are preferred again. "
+          "The batches of all fuzzing threads count, as the threads share "
+          "the selections. Use 0 to never forget a selection.");
+ABSL_FLAG(bool, reset_frontier_selection_when_exhausted,
+          Environment::Default().reset_frontier_selection_when_exhausted,
+          "If true, forget all frontier selections once every frontier PC in "
+          "the reduced corpus has been recently selected. Otherwise, select "
+          "from the whole reduced corpus until some selections expire.");
+ABSL_FLAG(bool, weighted_first_mover_selection,
+          Environment::Default().weighted_first_mover_selection,
+          "If true, select the seeds of a batch without replacement, with "
+          "probability proportional to the total frontier weight of their "
+          "frontier PCs not yet selected, so that the seeds of one batch "
+          "target distinct frontiers. Otherwise, select uniformly.");
+ABSL_FLAG(bool, frontier_mutation_budget,
+          Environment::Default().frontier_mutation_budget,
+          "If true, split the mutants of a batch between the seeds selected "
+          "by the coverage frontier proportionally to the total frontier "
+          "weight of the frontier PCs each seed was selected for, rather than "
+          "evenly. Only applies to the built-in mutators.");
+ABSL_FLAG(size_t, frontier_threads, Environment::Default().frontier_threads,
+          "Number of threads used by every shard to recompute coverage "
+          "frontier weights. Large recomputations are split by functions "
+          "across the threads; small ones always run on the shard's thread.");
 ABSL_FLAG(size_t, max_corpus_size, Environment::Default().max_corpus_size,
           "Indicates the number of inputs in the in-memory corpus after which"
           "more aggressive pruning will be applied.");
+ABSL_FLAG(bool, compress_corpus_features,
+          Environment::Default().compress_corpus_features,
+          "If true, the features of the in-memory corpus are kept sorted and "
+          "delta/varint-compressed, typically several times smaller, at the "
+          "cost of decompressing them when computing weights and pruning.");
 ABSL_FLAG(size_t, crossover_level, Environment::Default().crossover_level,
           "Defines how much crossover is used during mutations. 0 means no "
           "crossover, 100 means the most aggressive crossover. See "
@@ -317,6 +366,16 @@ ABSL_FLAG(bool, distill, Environment::Default().distill,
           "actual target binary; without it, it must be the full path. "
           "Each distillation thread writes a distilled corpus shard to "
           "to <--workdir>/distilled-<--coverage_binary basename>.<index>.");
+ABSL_FLAG(size_t, distill_frontier_covers,
+          Environment::Default().distill_frontier_covers,
+          "If > 0, --distill computes the coverage frontier of --binary over "
+          "all the --total_shards input shards and writes this many "
+          "randomized minimal frontier covers instead: cover k goes to "
+          "<--workdir>/distilled-<--coverage_binary basename>-cover<k>.<index> "
+          "with <index> the index of this process. Every cover has an "
+          "input for every frontier PC and no redundant inputs, and the covers "
+          "prefer different inputs from each other, making small and diverse "
+          "seed corpora. Requires the target binary, to read its CF table.");
 ABSL_RETIRED_FLAG(size_t, distill_shards, 0,
                   "No longer supported: use --distill instead.");
 ABSL_FLAG(size_t, log_features_shards,
@@ -470,10 +529,24 @@ Environment CreateEnvironmentFromFlags(const std::vector<std::string> &argv) {
       GetStopAtTime(absl::GetFlag(FLAGS_stop_at),
                     absl::GetFlag(FLAGS_stop_after)),
       /*fork_server=*/absl::GetFlag(FLAGS_fork_server),
+      /*fork_server_persistent_batches=*/
+      absl::GetFlag(FLAGS_fork_server_persistent_batches),
+      /*pipelined_execution=*/absl::GetFlag(FLAGS_pipelined_execution),
       /*full_sync=*/absl::GetFlag(FLAGS_full_sync),
       /*use_corpus_weights=*/absl::GetFlag(FLAGS_use_corpus_weights),
       /*use_coverage_frontier=*/absl::GetFlag(FLAGS_use_coverage_frontier),
+      /*frontier_selection_window=*/
+      absl::GetFlag(FLAGS_frontier_selection_window),
+      /*reset_frontier_selection_when_exhausted=*/
+      absl::GetFlag(FLAGS_reset_frontier_selection_when_exhausted),
+      /*weighted_first_mover_selection=*/
+      absl::GetFlag(FLAGS_weighted_first_mover_selection),
+      /*frontier_mutation_budget=*/
+      absl::GetFlag(FLAGS_frontier_mutation_budget),
+      /*frontier_threads=*/absl::GetFlag(FLAGS_frontier_threads),
       /*max_corpus_size=*/absl::GetFlag(FLAGS_max_corpus_size),
+      /*compress_corpus_features=*/
+      absl::GetFlag(FLAGS_compress_corpus_features),
       /*crossover_level=*/absl::GetFlag(FLAGS_crossover_level),
       /*use_pc_features=*/absl::GetFlag(FLAGS_use_pc_features),
       /*path_level=*/absl::GetFlag(FLAGS_path_level),
@@ -491,6 +564,7 @@ Environment CreateEnvironmentFromFlags(const std::vector<std::string> &argv) {
       /*telemetry_frequency=*/absl::GetFlag(FLAGS_telemetry_frequency),
       /*print_runner_log=*/absl::GetFlag(FLAGS_print_runner_log),
       /*distill=*/absl::GetFlag(FLAGS_distill),
+      /*distill_frontier_covers=*/absl::GetFlag(FLAGS_distill_frontier_covers),
       /*log_features_shards=*/absl::GetFlag(FLAGS_log_features_shards),
       /*knobs_file=*/absl::GetFlag(FLAGS_knobs_file),
       /*corpus_to_files=*/absl::GetFlag(FLAGS_corpus_to_files),
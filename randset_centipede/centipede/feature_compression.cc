@@ -0,0 +1,48 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./centipede/feature_compression.h"
+
+#include <cstdint>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "./centipede/feature.h"
+#include "./common/defs.h"
+
+namespace centipede {
+
+void CompressSortedFeatures(absl::Span<const feature_t> features,
+                            ByteArray &out) {
+  feature_t previous = 0;
+  for (const feature_t feature : features) {
+    CHECK_GE(feature, previous) << "Features must be sorted";
+    uint64_t delta = feature - previous;
+    previous = feature;
+    while (delta >= 0x80) {
+      out.push_back(static_cast<uint8_t>(delta | 0x80));
+      delta >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(delta));
+  }
+}
+
+void DecompressFeatures(ByteSpan compressed, FeatureVec &features) {
+  features.clear();
+  ForEachCompressedFeature(compressed, [&features](feature_t feature) {
+    features.push_back(feature);
+  });
+}
+
+}  // namespace centipede
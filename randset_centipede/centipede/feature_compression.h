@@ -0,0 +1,65 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CENTIPEDE_FEATURE_COMPRESSION_H_
+#define THIRD_PARTY_CENTIPEDE_FEATURE_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "./centipede/feature.h"
+#include "./common/defs.h"
+
+// Compressed feature vectors, for keeping many of them in memory.
+//
+// A compressed feature vector is the sorted features, each encoded as the
+// LEB128 varint of its difference from the previous feature (the first one
+// from 0). Sorted features are grouped by domain, and the features of one
+// domain are close to each other, so most differences take 1-3 bytes rather
+// than the 8 bytes of a feature_t.
+
+namespace centipede {
+
+// Appends the compressed `features` to `out`. `features` must be sorted.
+void CompressSortedFeatures(absl::Span<const feature_t> features,
+                            ByteArray &out);
+
+// Calls `callback(feature)` for every feature of `compressed`, in order,
+// without materializing them.
+template <typename Callback>
+void ForEachCompressedFeature(ByteSpan compressed, Callback callback) {
+  feature_t feature = 0;
+  size_t i = 0;
+  const size_t size = compressed.size();
+  while (i < size) {
+    uint64_t delta = 0;
+    for (int shift = 0;; shift += 7) {
+      DCHECK_LT(i, size) << "Truncated compressed features";
+      const uint8_t byte = compressed[i++];
+      delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) break;
+    }
+    feature += delta;
+    callback(feature);
+  }
+}
+
+// Replaces the contents of `features` with the decompressed `compressed`.
+void DecompressFeatures(ByteSpan compressed, FeatureVec &features);
+
+}  // namespace centipede
+
+#endif  // THIRD_PARTY_CENTIPEDE_FEATURE_COMPRESSION_H_
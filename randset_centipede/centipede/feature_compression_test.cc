@@ -0,0 +1,74 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./centipede/feature_compression.h"
+
+#include <cstdint>
+#include <limits>
+
+#include "gtest/gtest.h"
+#include "./centipede/feature.h"
+#include "./common/defs.h"
+
+namespace centipede {
+namespace {
+
+FeatureVec CompressAndDecompress(const FeatureVec &features) {
+  ByteArray compressed;
+  CompressSortedFeatures(features, compressed);
+  FeatureVec decompressed = {42};  // Overwritten.
+  DecompressFeatures(compressed, decompressed);
+  return decompressed;
+}
+
+TEST(FeatureCompression, RoundTrips) {
+  EXPECT_EQ(CompressAndDecompress({}), FeatureVec{});
+  EXPECT_EQ(CompressAndDecompress({0}), FeatureVec{0});
+  const FeatureVec features = {
+      feature_domains::kPCs.ConvertToMe(1),
+      feature_domains::kPCs.ConvertToMe(1),
+      feature_domains::kPCs.ConvertToMe(200),
+      feature_domains::kCMP.ConvertToMe(3),
+      feature_domains::kPCPair.ConvertToMe(1 << 20),
+      std::numeric_limits<feature_t>::max(),
+  };
+  EXPECT_EQ(CompressAndDecompress(features), features);
+}
+
+TEST(FeatureCompression, CloseFeaturesTakeFewBytes) {
+  FeatureVec features;
+  for (size_t i = 0; i < 100; ++i) {
+    features.push_back(feature_domains::k8bitCounters.ConvertToMe(i * 8));
+  }
+  ByteArray compressed;
+  CompressSortedFeatures(features, compressed);
+  // Every feature after the first one takes 1 byte.
+  ByteArray first;
+  CompressSortedFeatures({features.front()}, first);
+  EXPECT_EQ(compressed.size(), first.size() + features.size() - 1);
+  EXPECT_LT(compressed.size(), features.size() * sizeof(feature_t) / 4);
+}
+
+TEST(FeatureCompression, ForEachCompressedFeatureAppends) {
+  ByteArray compressed = {7};  // Not compressed features, kept.
+  CompressSortedFeatures({1, 2, 300}, compressed);
+  FeatureVec features;
+  ForEachCompressedFeature(
+      ByteSpan(compressed).subspan(1),
+      [&features](feature_t feature) { features.push_back(feature); });
+  EXPECT_EQ(features, FeatureVec({1, 2, 300}));
+}
+
+}  // namespace
+}  // namespace centipede
@@ -23,6 +23,7 @@
 
 #include "absl/log/check.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "./centipede/control_flow.h"
 #include "./centipede/feature.h"
 #include "./common/logging.h"
@@ -70,6 +71,16 @@ FeatureSet::PruneFeaturesAndCountUnseen(FeatureVec &features) const {
   return number_of_unseen_features;
 }
 
+size_t FeatureSet::CountUnseenFeatures(
+    absl::Span<const feature_t> features) const {
+  size_t number_of_unseen_features = 0;
+  for (auto feature : features) {
+    if (ShouldDiscardFeature(feature)) continue;
+    if (frequencies_[feature] == 0) ++number_of_unseen_features;
+  }
+  return number_of_unseen_features;
+}
+
 void FeatureSet::PruneDiscardedDomains(FeatureVec &features) const {
   size_t num_kept = 0;
   for (auto feature : features) {
@@ -92,7 +103,7 @@ void FeatureSet::IncrementFrequencies(const FeatureVec &features) {
 
 __attribute__((noinline))  // to see it in profile.
 uint64_t
-FeatureSet::ComputeWeight(const FeatureVec &features) const {
+FeatureSet::ComputeWeight(absl::Span<const feature_t> features) const {
   uint64_t weight = 0;
   for (auto feature : features) {
     // The less frequent is the feature, the more valuable it is.
@@ -23,6 +23,7 @@
 #include <string>
 
 #include "absl/log/log.h"
+#include "absl/types/span.h"
 #include "./centipede/control_flow.h"
 #include "./centipede/feature.h"
 #include "./centipede/util.h"
@@ -51,6 +52,9 @@ class FeatureSet {
   // previously present in `this`.
   size_t PruneFeaturesAndCountUnseen(FeatureVec &features) const;
 
+  // Returns what PruneFeaturesAndCountUnseen() would, without pruning.
+  size_t CountUnseenFeatures(absl::Span<const feature_t> features) const;
+
   // Prune the features that are in discarded domains.
   // Effectively a subset of PruneFeaturesAndCountUnseen.
   void PruneDiscardedDomains(FeatureVec &features) const;
@@ -89,7 +93,7 @@ class FeatureSet {
   // Computes combined weight of `features`.
   // The less frequent the feature is, the bigger its weight.
   // The weight of a FeatureVec is a sum of individual feature weights.
-  uint64_t ComputeWeight(const FeatureVec &features) const;
+  uint64_t ComputeWeight(absl::Span<const feature_t> features) const;
 
   // Returns a debug string representing the state of *this.
   std::string DebugString() const;
@@ -168,6 +168,26 @@ TEST(FeatureSet, PruneFeaturesAndCountUnseen_IncrementFrequencies) {
   EXPECT_EQ(features, FeatureVec({}));
 }
 
+TEST(FeatureSet, CountUnseenFeatures) {
+  std::bitset<feature_domains::kNumDomains> discarded_domains;
+  discarded_domains.set(feature_domains::kCMP.domain_id());
+  FeatureSet feature_set(/*frequency_threshold=*/2, discarded_domains);
+  const feature_t pc1 = feature_domains::kPCs.ConvertToMe(1);
+  const feature_t pc2 = feature_domains::kPCs.ConvertToMe(2);
+  const feature_t cmp = feature_domains::kCMP.ConvertToMe(1);
+  feature_set.IncrementFrequencies({pc1, pc1});
+
+  // Same count as PruneFeaturesAndCountUnseen(), and no pruning: the discarded
+  // and the frequent features are not unseen.
+  const FeatureVec features = {pc1, pc2, cmp};
+  EXPECT_EQ(feature_set.CountUnseenFeatures(features), 1);
+  FeatureVec pruned = features;
+  EXPECT_EQ(feature_set.PruneFeaturesAndCountUnseen(pruned), 1);
+  EXPECT_EQ(pruned, FeatureVec({pc2}));
+  feature_set.IncrementFrequencies(pruned);
+  EXPECT_EQ(feature_set.CountUnseenFeatures(features), 0);
+}
+
 TEST(FeatureSet, PruneDiscardedDomains) {
   for (size_t i = 0; i < feature_domains::kNumDomains; ++i) {
     SCOPED_TRACE(i);
@@ -21,40 +21,87 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
-#include <functional>
+
+#if defined(__AVX512BW__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace centipede {
 
+// The scans below look at blocks of this many bytes at once.
+inline constexpr size_t kNonZeroScanBlockSize = 64;
+
+// Returns the mask of the non-zero bytes among the kNonZeroScanBlockSize bytes
+// at `block`: bit `i` is set iff block[i] != 0. `block` may be unaligned.
+// Uses the widest vectors of the compilation target (AVX-512BW, AVX2 or SSE2),
+// or 64-bit words.
+inline uint64_t NonZeroByteMask(const uint8_t *block) {
+#if defined(__AVX512BW__)
+  const __m512i v = _mm512_loadu_si512(block);
+  return _mm512_test_epi8_mask(v, v);
+#elif defined(__AVX2__)
+  const __m256i zero = _mm256_setzero_si256();
+  const uint32_t zero_lo = static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block)), zero)));
+  const uint32_t zero_hi = static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32)),
+          zero)));
+  return ~((uint64_t{zero_hi} << 32) | zero_lo);
+#elif defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  uint64_t zero_mask = 0;
+  for (size_t i = 0; i < kNonZeroScanBlockSize; i += 16) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+    zero_mask |= uint64_t{static_cast<uint16_t>(
+                     _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)))}
+                 << i;
+  }
+  return ~zero_mask;
+#else
+  uint64_t mask = 0;
+  for (size_t i = 0; i < kNonZeroScanBlockSize; i += sizeof(uint64_t)) {
+    uint64_t word;
+    __builtin_memcpy(&word, block + i, sizeof(word));  // force inline.
+    if (!word) continue;
+    for (size_t pos = 0; pos < sizeof(word); pos++) {
+      if (block[i + pos]) mask |= uint64_t{1} << (i + pos);
+    }
+  }
+  return mask;
+#endif
+}
+
+// Calls action(offset + i, block[i]) for every non-zero block[i] among the
+// kNonZeroScanBlockSize bytes at `block`, in order. Then clears those bytes.
+template <typename Action>
+inline void ForEachNonZeroByteInBlock(uint8_t *block, size_t offset,
+                                      const Action &action) {
+  if (!NonZeroByteMask(block)) return;
+  // Take the values and clear them at once, then call `action`: the bytes
+  // may be set concurrently.
+  uint8_t values[kNonZeroScanBlockSize];
+  __builtin_memcpy(values, block, kNonZeroScanBlockSize);  // force inline.
+  __builtin_memset(block, 0, kNonZeroScanBlockSize);       // force inline.
+  for (uint64_t mask = NonZeroByteMask(values); mask; mask &= mask - 1) {
+    const size_t pos = __builtin_ctzll(mask);
+    action(offset + pos, values[pos]);
+  }
+}
+
 // Iterates over [bytes, bytes + num_bytes) and calls action(idx, bytes[idx]),
 // for every non-zero bytes[idx]. Then clears those non-zero bytes.
 // Optimized for the case where lots of bytes are zero.
+template <typename Action>
 inline void ForEachNonZeroByte(uint8_t *bytes, size_t num_bytes,
-                               std::function<void(size_t, uint8_t)> action) {
-  // The main loop will read words of this size.
-  constexpr uintptr_t kWordSize = sizeof(uintptr_t);
-  const uintptr_t initial_alignment =
-      reinterpret_cast<uintptr_t>(bytes) % kWordSize;
+                               const Action &action) {
   size_t idx = 0;
-  uintptr_t alignment = initial_alignment;
-  // Iterate the first few until we reach alignment by word size.
-  for (; idx < num_bytes && alignment != 0;
-       idx++, alignment = (alignment + 1) % kWordSize) {
-    if (bytes[idx]) {
-      action(idx, bytes[idx]);
-      bytes[idx] = 0;
-    }
-  }
-  // Iterate one word at a time. If the word is != 0, iterate its bytes.
-  for (; idx + kWordSize - 1 < num_bytes; idx += kWordSize) {
-    uintptr_t wide_load;
-    __builtin_memcpy(&wide_load, bytes + idx, kWordSize);  // force inline.
-    if (!wide_load) continue;
-    __builtin_memset(bytes + idx, 0, kWordSize);  // // force inline.
-    // This loop assumes little-endianness. (Tests will break on big-endian).
-    for (size_t pos = 0; pos < kWordSize; pos++) {
-      uint8_t value = wide_load >> (pos * 8);  // lowest byte is taken.
-      if (value) action(idx + pos, value);
-    }
+  // Iterate one block at a time, aligned or not.
+  for (; idx + kNonZeroScanBlockSize <= num_bytes;
+       idx += kNonZeroScanBlockSize) {
+    ForEachNonZeroByteInBlock(bytes + idx, idx, action);
   }
   // Iterate the last few.
   for (; idx < num_bytes; idx++) {
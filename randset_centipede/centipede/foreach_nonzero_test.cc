@@ -85,5 +85,22 @@ TEST(ForEachNonZeroByte, ProcessesSubArrays) {
   }
 }
 
+TEST(NonZeroByteMask, MasksNonZeroBytes) {
+  uint8_t block[kNonZeroScanBlockSize + 1] = {};
+  // Unaligned on purpose.
+  uint8_t *unaligned_block = block + 1;
+  EXPECT_EQ(NonZeroByteMask(unaligned_block), 0);
+  for (size_t i = 0; i < kNonZeroScanBlockSize; ++i) {
+    unaligned_block[i] = i + 1;
+    EXPECT_EQ(NonZeroByteMask(unaligned_block), uint64_t{1} << i);
+    // 0x80 is negative as a signed byte.
+    unaligned_block[i] = 0x80;
+    EXPECT_EQ(NonZeroByteMask(unaligned_block), uint64_t{1} << i);
+    unaligned_block[i] = 0;
+  }
+  memset(unaligned_block, 0xFF, kNonZeroScanBlockSize);
+  EXPECT_EQ(NonZeroByteMask(unaligned_block), ~uint64_t{0});
+}
+
 }  // namespace
 }  // namespace centipede
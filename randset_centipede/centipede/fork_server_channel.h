@@ -0,0 +1,148 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CENTIPEDE_FORK_SERVER_CHANNEL_H_
+#define THIRD_PARTY_CENTIPEDE_FORK_SERVER_CHANNEL_H_
+
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif  // __linux__
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+
+#include "absl/base/nullability.h"
+#include "./centipede/shared_memory_blob_sequence.h"
+
+// Like the blob sequence, this library must not depend on anything other than
+// libc: the fork server uses it before the process is fully initialized.
+
+namespace centipede {
+
+// The command channel between the engine and the fork server of a runner (see
+// runner_fork_server.cc), shared by the two processes. Requests and responses
+// are sequence numbers: the engine increments `request` to ask for one
+// execution of the runner, and whoever executed it sets `response` to the
+// number of the request it served, once `status` holds the execution status.
+// Both sides sleep on the counters with futexes, where available.
+struct ForkServerChannel {
+  std::atomic<uint32_t> request;
+  std::atomic<uint32_t> response;
+  // The request being served, for reporting it when the execution crashes.
+  std::atomic<uint32_t> serving;
+  // The wait status of the execution, as returned by waitpid().
+  int32_t status;
+  // Set by the engine when it no longer needs the fork server.
+  std::atomic<uint32_t> shutdown;
+  // The PID of the engine, to stop serving if the engine is gone.
+  int32_t engine_pid;
+  // Up to how many requests a forked runner may serve before exiting. 0 and 1
+  // mean one, i.e. a fresh fork for every request.
+  uint32_t persistent_batches;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "The channel counters must be usable across processes");
+
+inline constexpr Blob::SizeAndTagT kTagForkServerChannel = 1;
+
+// Lays out a new channel in `blobseq`, returns it. `blobseq` must be empty.
+inline absl::Nullable<ForkServerChannel *> CreateForkServerChannel(
+    BlobSequence &blobseq) {
+  // The blob sequence copies the bytes of the blob: write zeros, then find
+  // where they are.
+  uint8_t zeros[sizeof(ForkServerChannel)] = {};
+  blobseq.Reset();
+  if (!blobseq.Write({kTagForkServerChannel, sizeof(zeros), zeros})) {
+    return nullptr;
+  }
+  blobseq.Reset();
+  const Blob blob = blobseq.Read();
+  blobseq.Reset();
+  if (blob.tag != kTagForkServerChannel || blob.size != sizeof(zeros)) {
+    return nullptr;
+  }
+  // The blob data is in the shared memory and is 8-aligned.
+  return new (const_cast<uint8_t *>(blob.data)) ForkServerChannel{};
+}
+
+// Returns the channel laid out by CreateForkServerChannel() in `blobseq`, or
+// nullptr if there is none.
+inline absl::Nullable<ForkServerChannel *> OpenForkServerChannel(
+    BlobSequence &blobseq) {
+  blobseq.Reset();
+  const Blob blob = blobseq.Read();
+  blobseq.Reset();
+  if (blob.tag != kTagForkServerChannel ||
+      blob.size != sizeof(ForkServerChannel)) {
+    return nullptr;
+  }
+  return reinterpret_cast<ForkServerChannel *>(
+      const_cast<uint8_t *>(blob.data));
+}
+
+// Sleeps while `word` is `value`, for up to `timeout_ms` milliseconds. May
+// return early, so callers check the condition again.
+inline void ForkServerChannelWait(std::atomic<uint32_t> &word, uint32_t value,
+                                  int timeout_ms) {
+#ifdef __linux__
+  struct timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000};
+  // Not FUTEX_WAIT_PRIVATE: the word is shared by processes.
+  (void)syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT,
+                value, &timeout, nullptr, 0);
+#else   // __linux__
+  // No futexes: poll, with sleeps short enough for fast inputs.
+  constexpr int kPollIntervalUsec = 50;
+  for (int64_t slept_usec = 0; slept_usec < int64_t{timeout_ms} * 1000;
+       slept_usec += kPollIntervalUsec) {
+    if (word.load(std::memory_order_acquire) != value) return;
+    usleep(kPollIntervalUsec);
+  }
+#endif  // __linux__
+}
+
+// Wakes up the processes sleeping on `word` in ForkServerChannelWait().
+inline void ForkServerChannelWake(std::atomic<uint32_t> &word) {
+#ifdef __linux__
+  (void)syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE,
+                INT32_MAX, nullptr, nullptr, 0);
+#endif  // __linux__
+}
+
+// Stores `value` to `word` and wakes up the processes waiting on it.
+inline void ForkServerChannelPost(std::atomic<uint32_t> &word, uint32_t value) {
+  word.store(value, std::memory_order_release);
+  ForkServerChannelWake(word);
+}
+
+// Returns true iff the engine at the other end of `channel` has gone away:
+// it shut down the channel, or its process no longer exists.
+// `check_engine_pid` should be false if the engine's PID is not visible here,
+// e.g. when the runner is in another PID namespace.
+inline bool ForkServerChannelIsAbandoned(const ForkServerChannel &channel,
+                                         bool check_engine_pid) {
+  if (channel.shutdown.load(std::memory_order_acquire) != 0) return true;
+  return check_engine_pid && kill(channel.engine_pid, 0) != 0 &&
+         errno == ESRCH;
+}
+
+}  // namespace centipede
+
+#endif  // THIRD_PARTY_CENTIPEDE_FORK_SERVER_CHANNEL_H_
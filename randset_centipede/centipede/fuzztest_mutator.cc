@@ -101,26 +101,31 @@ void FuzzTestMutator::CrossOver(ByteArray &data, const ByteArray &other) {
 std::vector<ByteArray> FuzzTestMutator::MutateMany(
     const std::vector<MutationInputRef> &inputs, size_t num_mutants) {
   if (inputs.empty()) abort();
-  // TODO(xinhaoyuan): Consider metadata in other inputs instead of always the
-  // first one.
-  SetMetadata(inputs[0].metadata != nullptr ? *inputs[0].metadata
-                                            : ExecutionMetadata());
+  const std::vector<size_t> num_mutants_per_input =
+      NumMutantsPerInput(inputs, num_mutants);
   std::vector<ByteArray> mutants;
   mutants.reserve(num_mutants);
-  for (int i = 0; i < num_mutants; ++i) {
-    auto mutant = inputs[absl::Uniform<size_t>(prng_, 0, inputs.size())].data;
-    if (mutant.size() > max_len_) mutant.resize(max_len_);
-    if (knobs_.GenerateBool(knob_mutate_or_crossover, prng_())) {
-      // Perform crossover with some other input. It may be the same input.
-      const auto &other_input =
-          inputs[absl::Uniform<size_t>(prng_, 0, inputs.size())].data;
-      CrossOver(mutant, other_input);
-    } else {
-      domain_->Mutate(mutant, prng_,
-                      {/*cmp_tables=*/&mutation_metadata_->cmp_tables},
-                      /*only_shrink=*/false);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (num_mutants_per_input[i] == 0) continue;
+    // The CMP entries observed for this input become the most recent ones,
+    // which the domain mutation prefers.
+    SetMetadata(inputs[i].metadata != nullptr ? *inputs[i].metadata
+                                              : ExecutionMetadata());
+    for (size_t j = 0; j < num_mutants_per_input[i]; ++j) {
+      auto mutant = inputs[i].data;
+      if (mutant.size() > max_len_) mutant.resize(max_len_);
+      if (knobs_.GenerateBool(knob_mutate_or_crossover, prng_())) {
+        // Perform crossover with some other input. It may be the same input.
+        const auto &other_input =
+            inputs[absl::Uniform<size_t>(prng_, 0, inputs.size())].data;
+        CrossOver(mutant, other_input);
+      } else {
+        domain_->Mutate(mutant, prng_,
+                        {/*cmp_tables=*/&mutation_metadata_->cmp_tables},
+                        /*only_shrink=*/false);
+      }
+      mutants.push_back(std::move(mutant));
     }
-    mutants.push_back(std::move(mutant));
   }
   return mutants;
 }
@@ -19,6 +19,8 @@
 #ifndef THIRD_PARTY_CENTIPEDE_MUTATION_INPUT_H_
 #define THIRD_PARTY_CENTIPEDE_MUTATION_INPUT_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "./centipede/execution_metadata.h"
@@ -26,12 +28,53 @@
 
 namespace centipede {
 
-// {data (required), metadata (optional)} reference pairs as mutation inputs.
+// {data (required), metadata (optional), weight (optional)} references as
+// mutation inputs.
 struct MutationInputRef {
   const ByteArray &data;
   const ExecutionMetadata *metadata = nullptr;
+  // The share of the mutants to derive from `data`, relative to the weights of
+  // the other inputs. If all the inputs have weight 0, the mutants are spread
+  // evenly.
+  uint64_t weight = 0;
 };
 
+// Returns how many of `num_mutants` mutants to derive from each of `inputs`:
+// proportionally to their weights, or evenly if all of them are 0. The counts
+// add up to `num_mutants`; the remainders go to the largest fractions first.
+inline std::vector<size_t> NumMutantsPerInput(
+    const std::vector<MutationInputRef> &inputs, size_t num_mutants) {
+  std::vector<size_t> counts(inputs.size(), 0);
+  if (inputs.empty()) return counts;
+  uint64_t total_weight = 0;
+  for (const auto &input : inputs) total_weight += input.weight;
+  const bool even = total_weight == 0;
+  if (even) total_weight = inputs.size();
+  auto weight = [&](size_t i) -> uint64_t {
+    return even ? 1 : inputs[i].weight;
+  };
+  // Integer shares, and the remainders of the exact shares.
+  std::vector<uint64_t> remainders(inputs.size());
+  size_t num_assigned = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const __uint128_t share = static_cast<__uint128_t>(num_mutants) * weight(i);
+    counts[i] = share / total_weight;
+    remainders[i] = share % total_weight;
+    num_assigned += counts[i];
+  }
+  // Fewer than inputs.size() mutants are left, at most one per input.
+  while (num_assigned < num_mutants) {
+    size_t largest = 0;
+    for (size_t i = 1; i < inputs.size(); ++i) {
+      if (remainders[i] > remainders[largest]) largest = i;
+    }
+    ++counts[largest];
+    remainders[largest] = 0;
+    ++num_assigned;
+  }
+  return counts;
+}
+
 inline std::vector<ByteArray> CopyDataFromMutationInputRefs(
     const std::vector<MutationInputRef> &inputs) {
   std::vector<ByteArray> results;
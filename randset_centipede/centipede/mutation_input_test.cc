@@ -14,6 +14,7 @@
 
 #include "./centipede/mutation_input.h"
 
+#include <cstddef>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -23,6 +24,8 @@
 namespace centipede {
 namespace {
 
+using ::testing::ElementsAre;
+
 TEST(MutationInputTest, ConvertsDataToMutationInputRefsAndBack) {
   EXPECT_THAT(
       CopyDataFromMutationInputRefs(GetMutationInputRefsFromDataInputs({})),
@@ -33,5 +36,44 @@ TEST(MutationInputTest, ConvertsDataToMutationInputRefsAndBack) {
             data_inputs);
 }
 
+TEST(NumMutantsPerInput, SpreadsEvenlyWithoutWeights) {
+  const ByteArray data = {1, 2, 3};
+  const std::vector<MutationInputRef> inputs = {{data}, {data}, {data}};
+  EXPECT_THAT(NumMutantsPerInput(inputs, 9), ElementsAre(3, 3, 3));
+  // The remainder goes to the first inputs, all having the same fraction.
+  EXPECT_THAT(NumMutantsPerInput(inputs, 10), ElementsAre(4, 3, 3));
+  EXPECT_THAT(NumMutantsPerInput(inputs, 2), ElementsAre(1, 1, 0));
+  EXPECT_THAT(NumMutantsPerInput(inputs, 0), ElementsAre(0, 0, 0));
+}
+
+TEST(NumMutantsPerInput, FollowsWeights) {
+  const ByteArray data = {1, 2, 3};
+  const std::vector<MutationInputRef> inputs = {
+      {data, nullptr, /*weight=*/6},
+      {data, nullptr, /*weight=*/3},
+      {data, nullptr, /*weight=*/0},
+      {data, nullptr, /*weight=*/1},
+  };
+  EXPECT_THAT(NumMutantsPerInput(inputs, 100), ElementsAre(60, 30, 0, 10));
+  // Exact shares 3, 1.5, 0, 0.5: the remainder goes to the largest fraction
+  // first.
+  EXPECT_THAT(NumMutantsPerInput(inputs, 5), ElementsAre(3, 2, 0, 0));
+}
+
+TEST(NumMutantsPerInput, AddsUpToNumMutants) {
+  const ByteArray data = {1};
+  std::vector<MutationInputRef> inputs;
+  for (size_t i = 0; i < 7; ++i) {
+    inputs.push_back({data, nullptr, /*weight=*/i * i + 1});
+  }
+  for (size_t num_mutants = 0; num_mutants < 100; ++num_mutants) {
+    size_t total = 0;
+    for (size_t count : NumMutantsPerInput(inputs, num_mutants)) {
+      total += count;
+    }
+    EXPECT_EQ(total, num_mutants);
+  }
+}
+
 }  // namespace
 }  // namespace centipede
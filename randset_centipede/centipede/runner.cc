@@ -749,6 +749,10 @@ static bool FinishSendingOutputsToEngine(BlobSequence &outputs_blobseq) {
       return BatchResult::WriteOneFeatureVec(result.features().data(),
                                              result.features().size(),
                                              outputs_blobseq) &&
+             BatchResult::WriteFeaturesDigest(
+                 FeaturesDigest(result.features().data(),
+                                result.features().size()),
+                 outputs_blobseq) &&
              BatchResult::WriteMetadata(result.metadata(), outputs_blobseq) &&
              BatchResult::WriteStats(result.stats(), outputs_blobseq) &&
              BatchResult::WriteInputEnd(outputs_blobseq);
@@ -760,6 +764,11 @@ static bool FinishSendingOutputsToEngine(BlobSequence &outputs_blobseq) {
           state.g_features.data(), state.g_features.size(), outputs_blobseq)) {
     return false;
   }
+  if (!BatchResult::WriteFeaturesDigest(
+          FeaturesDigest(state.g_features.data(), state.g_features.size()),
+          outputs_blobseq)) {
+    return false;
+  }
 
   ExecutionMetadata metadata;
   // Copy the CMP traces to shared memory.
@@ -799,7 +808,9 @@ static int ExecuteInputsFromShmem(BlobSequence &inputs_blobseq,
   for (size_t i = 0; i < num_inputs; i++) {
     auto blob = inputs_blobseq.Read();
     // TODO(kcc): distinguish bad input from end of stream.
-    if (!blob.IsValid()) return EXIT_SUCCESS;  // no more blobs to read.
+    // No more blobs to read, e.g. the engine could not fit all the inputs.
+    // The batch still needs to end: a persistent runner serves more batches.
+    if (!blob.IsValid()) break;
     if (!runner_request::IsDataInput(blob)) return EXIT_FAILURE;
 
     // TODO(kcc): [impl] handle sizes larger than kMaxDataSize.
@@ -1069,6 +1080,8 @@ static void MaybePopulateReversePcTable() {
 extern void ForkServerCallMeVeryEarly();
 [[maybe_unused]] auto fake_reference_for_fork_server =
     &ForkServerCallMeVeryEarly;
+// Defined in runner_fork_server.cc, for the same reason.
+extern bool ForkServerServeNextRequest(int status);
 // Same for runner_sancov.cc. Avoids the following situation:
 // * weak implementations of sancov callbacks are given in the command line
 //   before centipede.a.
@@ -1180,29 +1193,40 @@ int RunnerMain(int argc, char **argv, RunnerCallbacks &callbacks) {
     if (!state.arg1 || !state.arg2) return EXIT_FAILURE;
     SharedMemoryBlobSequence inputs_blobseq(state.arg1);
     SharedMemoryBlobSequence outputs_blobseq(state.arg2);
-    // Read the first blob. It indicates what further actions to take.
-    auto request_type_blob = inputs_blobseq.Read();
-    if (runner_request::IsMutationRequest(request_type_blob)) {
-      // Since we are mutating, no need to spend time collecting the coverage.
-      // We still pay for executing the coverage callbacks, but those will
-      // return immediately.
-      // TODO(kcc): do this more consistently, for all coverage types.
-      state.run_time_flags.use_cmp_features = false;
-      state.run_time_flags.use_pc_features = false;
-      state.run_time_flags.use_dataflow_features = false;
-      state.run_time_flags.use_counter_features = false;
-      // Mutation request.
+    // Execution requests may be served back to back by this process, if the
+    // fork server allows it.
+    int result = EXIT_FAILURE;
+    do {
       inputs_blobseq.Reset();
-      state.byte_array_mutator =
-          new ByteArrayMutator(state.knobs, GetRandomSeed());
-      return MutateInputsFromShmem(inputs_blobseq, outputs_blobseq, callbacks);
-    }
-    if (runner_request::IsExecutionRequest(request_type_blob)) {
+      outputs_blobseq.Reset();
+      // Read the first blob. It indicates what further actions to take.
+      auto request_type_blob = inputs_blobseq.Read();
+      if (runner_request::IsMutationRequest(request_type_blob)) {
+        // Since we are mutating, no need to spend time collecting the
+        // coverage. We still pay for executing the coverage callbacks, but
+        // those will return immediately.
+        // TODO(kcc): do this more consistently, for all coverage types.
+        state.run_time_flags.use_cmp_features = false;
+        state.run_time_flags.use_pc_features = false;
+        state.run_time_flags.use_dataflow_features = false;
+        state.run_time_flags.use_counter_features = false;
+        // Mutation request.
+        inputs_blobseq.Reset();
+        state.byte_array_mutator =
+            new ByteArrayMutator(state.knobs, GetRandomSeed());
+        // The coverage flags are off now: not good for further requests.
+        return MutateInputsFromShmem(inputs_blobseq, outputs_blobseq,
+                                     callbacks);
+      }
+      if (!runner_request::IsExecutionRequest(request_type_blob)) {
+        return EXIT_FAILURE;
+      }
       // Execution request.
       inputs_blobseq.Reset();
-      return ExecuteInputsFromShmem(inputs_blobseq, outputs_blobseq, callbacks);
-    }
-    return EXIT_FAILURE;
+      result = ExecuteInputsFromShmem(inputs_blobseq, outputs_blobseq,
+                                      callbacks);
+    } while (ForkServerServeNextRequest(result));
+    return result;
   }
 
   // By default, run every input file one-by-one.
@@ -15,24 +15,35 @@
 // Fork server, a.k.a. a process Zygote, for the Centipede runner.
 //
 // Startup:
-// * Centipede creates two named FIFO pipes: pipe0 and pipe1.
-// * Centipede runs the target in background, and passes the FIFO names to it
-//   using two environment variables: CENTIPEDE_FORK_SERVER_FIFO[01].
-// * Centipede opens the pipe0 for writing, pipe1 for reading.
-//   These would block until the same pipes are open in the runner.
-// * Runner, early at startup, checks if it is given the pipe names.
-//    If so, it opens pipe0 for reading, pipe1 for writing,
-//    and enters the infinite fork-server loop.
+// * Centipede creates a command channel (see fork_server_channel.h) in a
+//   shared memory blob sequence.
+// * Centipede runs the target in background, and passes the blob sequence path
+//   to it using the environment variable CENTIPEDE_FORK_SERVER_CHANNEL.
+// * Runner, early at startup, checks if it is given the channel.
+//    If so, it opens it and enters the infinite fork-server loop.
 // Loop:
-// * Centipede writes a byte to pipe0.
-// * Runner blocks until it reads a byte from pipe0, then forks and waits.
+// * Centipede increments the request counter of the channel and wakes up the
+//   runner.
+// * Runner sleeps until the request counter differs from the response counter,
+//   then forks and waits.
 //   This is where the child process executes and does the work.
 //   This works because every execution of the target has the same arguments.
-// * Runner receives the child exit status and writes it to pipe1.
-// * Centipede blocks until it reads the status from pipe1.
+// * Runner receives the child exit status, writes it to the channel, sets the
+//   response counter to the served request and wakes up Centipede.
+// * Centipede sleeps until the response counter is its request, then reads the
+//   status.
+// Persistent mode:
+// * If Centipede allows it, a child that successfully handled an execution
+//   request responds itself (see ForkServerServeNextRequest()), then sleeps
+//   until the next request and handles it too, without a new fork. It exits
+//   after the allowed number of requests, so that the exit-time checks like
+//   leak detection still run, or on the first failure. The fork server then
+//   reports the exit status of the request being served, if any, and forks a
+//   fresh child for the next request.
 // Exit:
-// * Centipede closes the pipes (and then deletes them).
-// * Runner (the fork server) fails on the next read from pipe0 and exits.
+// * Centipede sets the shutdown flag of the channel.
+// * Runner (the fork server) notices it, or notices that Centipede is gone,
+//   while waiting for the next request, and exits.
 //
 // The fork server code kicks in super-early in the process startup,
 // via injecting itself into the `.preinit_array`.
@@ -52,6 +63,7 @@
 // works too early in the process. E.g. getenv() will not work yet.
 
 #include <fcntl.h>
+#include <signal.h>
 #ifdef __APPLE__
 #include <sys/sysctl.h>
 #else                      // __APPLE__
@@ -60,11 +72,16 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 
 #include "absl/base/nullability.h"
+#include "./centipede/fork_server_channel.h"
+#include "./centipede/shared_memory_blob_sequence.h"
 
 namespace centipede {
 
@@ -73,6 +90,17 @@ namespace {
 constexpr bool kForkServerDebug = false;
 [[maybe_unused]] constexpr bool kForkServerDumpEnvAtStart = false;
 
+// How long to sleep on the channel between checks that Centipede is alive.
+constexpr int kChannelWaitTimeoutMs = 1000;
+
+// The channel, set in the fork server and inherited by the forked children.
+ForkServerChannel *channel = nullptr;
+// Whether the PID of Centipede is visible to this process.
+bool check_engine_pid = false;
+// In a forked child: how many more requests it may serve, including the
+// current one.
+uint32_t requests_left = 0;
+
 }  // namespace
 
 // Writes a C string to stderr when debugging, no-op otherwise.
@@ -175,13 +203,47 @@ absl::Nullable<const char *> GetOneEnv(absl::Nonnull<const char *> key) {
   return nullptr;
 }
 
-// Starts the fork server if the pipes are given.
+// Resets stdout/stderr for a new execution.
+static void ResetOutputFiles() {
+  for (int fd = 1; fd <= 2; fd++) {
+    lseek(fd, 0, SEEK_SET);
+    // NOTE: Allow ftruncate() to fail by ignoring its return; that okay to
+    // happen when the stdout/stderr are not redirected to a file.
+    (void)ftruncate(fd, 0);
+  }
+}
+
+// Called by the runner in a child forked by the fork server, after it handled
+// an execution request with `status`. If the child may serve more requests,
+// responds to the current one, waits for the next one and returns true.
+// Otherwise, returns false: the child should exit with `status`.
+bool ForkServerServeNextRequest(int status) {
+  if (channel == nullptr || status != EXIT_SUCCESS || requests_left <= 1) {
+    return false;
+  }
+  --requests_left;
+  // Nothing buffered should go to the outputs of the next execution.
+  fflush(nullptr);
+  const uint32_t served = channel->serving.load(std::memory_order_acquire);
+  channel->status = 0;  // As if exited with EXIT_SUCCESS.
+  ForkServerChannelPost(channel->response, served);
+  while (channel->request.load(std::memory_order_acquire) == served) {
+    if (ForkServerChannelIsAbandoned(*channel, check_engine_pid)) return false;
+    ForkServerChannelWait(channel->request, served, kChannelWaitTimeoutMs);
+  }
+  channel->serving.store(channel->request.load(std::memory_order_acquire),
+                         std::memory_order_release);
+  ResetOutputFiles();
+  return true;
+}
+
+// Starts the fork server if the channel is given.
 // This function is called from `.preinit_array` when linked statically,
 // or from the DSO constructor when injected via LD_PRELOAD.
 // Note: it must run before the GlobalRunnerState constructor because
 // GlobalRunnerState may terminate the process early due to an error,
-// then we never open the fifos and the corresponding opens in centipede
-// hang forever.
+// then we never open the channel and centipede waits for the responses in
+// vain.
 // The priority 150 is chosen on the lower end (higher priority)
 // of the user-available range (101-999) to allow ordering with other
 // constructors and C++ constructors (init_priority). Note: constructors
@@ -195,34 +257,41 @@ __attribute__((constructor(150))) void ForkServerCallMeVeryEarly() {
   called_already = true;
   // Startup.
   GetAllEnv();
-  const char *pipe0_name = GetOneEnv("CENTIPEDE_FORK_SERVER_FIFO0=");
-  const char *pipe1_name = GetOneEnv("CENTIPEDE_FORK_SERVER_FIFO1=");
-  if (!pipe0_name || !pipe1_name) return;
+  const char *channel_path = GetOneEnv("CENTIPEDE_FORK_SERVER_CHANNEL=");
+  if (!channel_path) return;
   Log("###Centipede fork server requested\n");
-  int pipe0 = open(pipe0_name, O_RDONLY);
-  if (pipe0 < 0) Exit("###open pipe0 failed\n");
-  int pipe1 = open(pipe1_name, O_WRONLY);
-  if (pipe1 < 0) Exit("###open pipe1 failed\n");
+  // No malloc, and no destructor: the children may use the channel until
+  // they exit.
+  alignas(SharedMemoryBlobSequence) static char
+      channel_blobseq_storage[sizeof(SharedMemoryBlobSequence)];
+  auto *channel_blobseq =
+      new (channel_blobseq_storage) SharedMemoryBlobSequence(channel_path);
+  channel = OpenForkServerChannel(*channel_blobseq);
+  if (channel == nullptr) Exit("###open channel failed\n");
+  check_engine_pid = kill(channel->engine_pid, 0) == 0;
   Log("###Centipede fork server ready\n");
 
   // Loop.
   while (true) {
-    Log("###Centipede fork server blocking on pipe0\n");
-    // This read will fail when Centipede shuts down the pipes.
-    char ch = 0;
-    if (read(pipe0, &ch, 1) != 1) Exit("###read from pipe0 failed\n");
+    const uint32_t response = channel->response.load(std::memory_order_acquire);
+    const uint32_t request = channel->request.load(std::memory_order_acquire);
+    if (request == response) {
+      if (ForkServerChannelIsAbandoned(*channel, check_engine_pid)) {
+        Exit("###Centipede fork server shutting down\n");
+      }
+      Log("###Centipede fork server waiting for a request\n");
+      ForkServerChannelWait(channel->request, request, kChannelWaitTimeoutMs);
+      continue;
+    }
+    channel->serving.store(request, std::memory_order_release);
     Log("###Centipede starting fork\n");
     auto pid = fork();
     if (pid < 0) {
       Exit("###fork failed\n");
     } else if (pid == 0) {
       // Child process. Reset stdout/stderr and let it run normally.
-      for (int fd = 1; fd <= 2; fd++) {
-        lseek(fd, 0, SEEK_SET);
-        // NOTE: Allow ftruncate() to fail by ignoring its return; that okay to
-        // happen when the stdout/stderr are not redirected to a file.
-        (void)ftruncate(fd, 0);
-      }
+      ResetOutputFiles();
+      requests_left = channel->persistent_batches;
       return;
     } else {
       // Parent process.
@@ -238,9 +307,13 @@ __attribute__((constructor(150))) void ForkServerCallMeVeryEarly() {
       } else {
         Log("###Centipede fork crashed\n");
       }
-      Log("###Centipede fork writing status to pipe1\n");
-      if (write(pipe1, &status, sizeof(status)) == -1)
-        Exit("###write to pipe1 failed\n");
+      // A persistent child may have responded to all its requests already.
+      const uint32_t served = channel->serving.load(std::memory_order_acquire);
+      if (channel->response.load(std::memory_order_acquire) != served) {
+        Log("###Centipede fork writing status to the channel\n");
+        channel->status = status;
+        ForkServerChannelPost(channel->response, served);
+      }
     }
   }
   // The only way out of the loop is via Exit() or return.
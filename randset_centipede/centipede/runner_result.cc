@@ -14,6 +14,7 @@
 
 #include "./centipede/runner_result.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -43,16 +44,37 @@ enum Tags : Blob::SizeAndTagT {
   // Mutation result tags.
   kTagHasCustomMutator,
   kTagMutant,
+
+  // Execution result tags added later, kept last so that the values of the
+  // other tags do not change.
+  kTagFeaturesDigest,
 };
 
 }  // namespace
 
+uint64_t FeaturesDigest(const feature_t *vec, size_t size) {
+  uint64_t digest = 0;
+  for (size_t i = 0; i < size; ++i) {
+    // The splitmix64 finalizer: close features give unrelated terms.
+    uint64_t x = vec[i] + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    digest += x ^ (x >> 31);
+  }
+  return digest == 0 ? 1 : digest;
+}
+
 bool BatchResult::WriteOneFeatureVec(const feature_t *vec, size_t size,
                                      BlobSequence &blobseq) {
   return blobseq.Write({kTagFeatures, size * sizeof(vec[0]),
                         reinterpret_cast<const uint8_t *>(vec)});
 }
 
+bool BatchResult::WriteFeaturesDigest(uint64_t digest, BlobSequence &blobseq) {
+  return blobseq.Write({kTagFeaturesDigest, sizeof(digest),
+                        reinterpret_cast<const uint8_t *>(&digest)});
+}
+
 bool BatchResult::WriteInputBegin(BlobSequence &blobseq) {
   return blobseq.Write({kTagInputBegin, 0, nullptr});
 }
@@ -111,9 +133,24 @@ bool BatchResult::Read(BlobSequence &blobseq) {
       memcpy(&current_execution_result->stats(), blob.data, blob.size);
       continue;
     }
+    if (blob.tag == kTagFeaturesDigest) {
+      if (current_execution_result == nullptr) return false;
+      if (blob.size != sizeof(uint64_t)) return false;
+      memcpy(&current_execution_result->features_digest(), blob.data,
+             blob.size);
+      continue;
+    }
     if (blob.tag == kTagFeatures) {
       if (current_execution_result == nullptr) return false;
       const size_t features_size = blob.size / sizeof(feature_t);
+      // Blobs are not padded: share only the aligned features.
+      if (share_features_ &&
+          reinterpret_cast<uintptr_t>(blob.data) % alignof(feature_t) == 0) {
+        current_execution_result->shared_features_ = {
+            reinterpret_cast<const feature_t *>(blob.data), features_size};
+        current_execution_result->shares_features_ = true;
+        continue;
+      }
       FeatureVec &features = current_execution_result->mutable_features();
       features.resize(features_size);
       std::memcpy(features.data(), blob.data,
@@ -23,6 +23,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "./centipede/execution_metadata.h"
 #include "./centipede/feature.h"
 #include "./centipede/shared_memory_blob_sequence.h"
@@ -67,28 +68,63 @@ class ExecutionResult {
   };
 
   // Accessors.
+  // The features must be owned, see shares_features().
   const FeatureVec& features() const { return features_; }
-  FeatureVec& mutable_features() { return features_; }
+  // Copies the shared features into owned ones first, if needed.
+  FeatureVec& mutable_features() {
+    if (shares_features_) {
+      features_.assign(shared_features_.begin(), shared_features_.end());
+      shares_features_ = false;
+    }
+    return features_;
+  }
+  // The features, owned or shared.
+  absl::Span<const feature_t> features_view() const {
+    return shares_features_ ? shared_features_
+                            : absl::Span<const feature_t>(features_);
+  }
+  // True iff the features are not owned, but are a view of the memory they
+  // were read from, see BatchResult::set_share_features().
+  bool shares_features() const { return shares_features_; }
   const Stats& stats() const { return stats_; }
   Stats& stats() { return stats_; }
   const ExecutionMetadata& metadata() const { return metadata_; }
   ExecutionMetadata& metadata() { return metadata_; }
+  uint64_t features_digest() const { return features_digest_; }
+  uint64_t& features_digest() { return features_digest_; }
 
   // Clears the data, but doesn't deallocate the heap storage.
   void clear() {
     features_.clear();
+    shares_features_ = false;
+    shared_features_ = {};
+    features_digest_ = 0;
     metadata_ = {};
     stats_ = {};
   }
 
  private:
+  friend class BatchResult;
+
   FeatureVec features_;  // Features produced by the target on one input.
+  // If shares_features_, the features are shared_features_ instead.
+  bool shares_features_ = false;
+  absl::Span<const feature_t> shared_features_;
+
+  // FeaturesDigest() of features_ as computed by the runner, or 0 if the
+  // runner did not send it.
+  uint64_t features_digest_ = 0;
 
   ExecutionMetadata metadata_;  // Metadata from executing one input.
 
   Stats stats_;  // Stats from executing one input.
 };
 
+// Returns a digest of the `size` features at `vec`, which does not depend on
+// their order and is never 0. Equal feature vectors have equal digests;
+// different ones collide with a negligible probability.
+uint64_t FeaturesDigest(const feature_t* vec, size_t size);
+
 // BatchResult is the communication API between Centipede and its runner.
 // In consists of a vector of ExecutionResult objects, one per executed input,
 // and optionally some other details about the execution of the input batch.
@@ -121,6 +157,9 @@ class BatchResult {
   // When executing N inputs, the runner will call this at most N times.
   static bool WriteOneFeatureVec(const feature_t* vec, size_t size,
                                  BlobSequence& blobseq);
+  // Writes the FeaturesDigest() of the FeatureVec of the current input.
+  // Optional: lets Centipede skip the inputs with already seen features.
+  static bool WriteFeaturesDigest(uint64_t digest, BlobSequence& blobseq);
   // Writes a special Begin marker before executing an input.
   static bool WriteInputBegin(BlobSequence& blobseq);
   // Writes a special End marker after executing an input.
@@ -138,6 +177,19 @@ class BatchResult {
   // When running N inputs, ClearAndResize(N) must be called before Read().
   bool Read(BlobSequence& blobseq);
 
+  // If `share_features`, Read() does not copy the features out of `blobseq`:
+  // the results share them, see ExecutionResult::shares_features(), and are
+  // valid only while the contents of `blobseq` are. Most inputs add no new
+  // features, so their features need never be copied. Off by default.
+  void set_share_features(bool share_features) {
+    share_features_ = share_features;
+  }
+  bool share_features() const { return share_features_; }
+  // Makes all the results own their features.
+  void CopySharedFeatures() {
+    for (auto& result : results_) result.mutable_features();
+  }
+
   // Returns true if the batch execution failed due to a setup failure, and not
   // a crash tied to a specific input.
   bool IsSetupFailure() const;
@@ -166,6 +218,7 @@ class BatchResult {
   // description, e.g., the crash type, stack trace...
   std::string failure_description_;
   size_t num_outputs_read_ = 0;
+  bool share_features_ = false;
 };
 
 // Represents results of mutating a batch of inputs, which are communicated from
@@ -14,6 +14,7 @@
 
 #include "./centipede/runner_result.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <cstdlib>
@@ -37,6 +38,7 @@ namespace centipede {
 namespace {
 
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 
 TEST(ExecutionResult, WriteThenRead) {
   auto buffer = std::make_unique<uint8_t[]>(1000);
@@ -166,6 +168,86 @@ TEST(ExecutionResult, WriteIntoFileThenRead) {
                           ));
 }
 
+TEST(ExecutionResult, ReadsFeaturesDigest) {
+  auto buffer = std::make_unique<uint8_t[]>(1000);
+  BlobSequence blobseq(buffer.get(), 1000);
+  FeatureVec v1{1, 2, 3};
+  FeatureVec v2{5, 6, 7, 8};
+
+  // The runner may or may not send the digest.
+  EXPECT_TRUE(BatchResult::WriteInputBegin(blobseq));
+  EXPECT_TRUE(BatchResult::WriteOneFeatureVec(v1.data(), v1.size(), blobseq));
+  EXPECT_TRUE(BatchResult::WriteFeaturesDigest(
+      FeaturesDigest(v1.data(), v1.size()), blobseq));
+  EXPECT_TRUE(BatchResult::WriteInputEnd(blobseq));
+  EXPECT_TRUE(BatchResult::WriteInputBegin(blobseq));
+  EXPECT_TRUE(BatchResult::WriteOneFeatureVec(v2.data(), v2.size(), blobseq));
+  EXPECT_TRUE(BatchResult::WriteInputEnd(blobseq));
+
+  blobseq.Reset();
+  BatchResult batch_result;
+  batch_result.ClearAndResize(2);
+  ASSERT_TRUE(batch_result.Read(blobseq));
+  EXPECT_EQ(batch_result.results()[0].features(), v1);
+  EXPECT_EQ(batch_result.results()[0].features_digest(),
+            FeaturesDigest(v1.data(), v1.size()));
+  EXPECT_EQ(batch_result.results()[1].features(), v2);
+  EXPECT_EQ(batch_result.results()[1].features_digest(), 0);
+}
+
+TEST(ExecutionResult, SharesFeaturesUntilCopied) {
+  auto buffer = std::make_unique<uint64_t[]>(125);
+  BlobSequence blobseq(reinterpret_cast<uint8_t *>(buffer.get()), 1000);
+  FeatureVec v1{1, 2, 3};
+  FeatureVec v2{5, 6, 7, 8};
+  EXPECT_TRUE(BatchResult::WriteInputBegin(blobseq));
+  EXPECT_TRUE(BatchResult::WriteOneFeatureVec(v1.data(), v1.size(), blobseq));
+  EXPECT_TRUE(BatchResult::WriteInputEnd(blobseq));
+  EXPECT_TRUE(BatchResult::WriteInputBegin(blobseq));
+  EXPECT_TRUE(BatchResult::WriteOneFeatureVec(v2.data(), v2.size(), blobseq));
+  EXPECT_TRUE(BatchResult::WriteInputEnd(blobseq));
+
+  blobseq.Reset();
+  BatchResult batch_result;
+  batch_result.set_share_features(true);
+  batch_result.ClearAndResize(2);
+  ASSERT_TRUE(batch_result.Read(blobseq));
+  ExecutionResult &result1 = batch_result.results()[0];
+  ExecutionResult &result2 = batch_result.results()[1];
+  ASSERT_TRUE(result1.shares_features());
+  ASSERT_TRUE(result2.shares_features());
+  EXPECT_THAT(result1.features_view(), ElementsAreArray(v1));
+  EXPECT_THAT(result2.features_view(), ElementsAreArray(v2));
+
+  // Copies the features, which then outlive the shared memory.
+  EXPECT_EQ(result1.mutable_features(), v1);
+  EXPECT_FALSE(result1.shares_features());
+  batch_result.CopySharedFeatures();
+  EXPECT_FALSE(result2.shares_features());
+  std::fill(buffer.get(), buffer.get() + 125, 0);
+  EXPECT_EQ(result1.features(), v1);
+  EXPECT_EQ(result2.features(), v2);
+
+  // A cleared result owns its (no) features.
+  batch_result.ClearAndResize(2);
+  EXPECT_FALSE(batch_result.results()[0].shares_features());
+  EXPECT_TRUE(batch_result.results()[0].features_view().empty());
+}
+
+TEST(FeaturesDigest, DependsOnFeaturesNotOrder) {
+  const FeatureVec v1{1, 2, 3};
+  const FeatureVec v1_reordered{3, 1, 2};
+  const FeatureVec v2{1, 2, 4};
+  const FeatureVec v3{1, 2};
+  EXPECT_EQ(FeaturesDigest(v1.data(), v1.size()),
+            FeaturesDigest(v1_reordered.data(), v1_reordered.size()));
+  EXPECT_NE(FeaturesDigest(v1.data(), v1.size()),
+            FeaturesDigest(v2.data(), v2.size()));
+  EXPECT_NE(FeaturesDigest(v1.data(), v1.size()),
+            FeaturesDigest(v3.data(), v3.size()));
+  EXPECT_NE(FeaturesDigest(nullptr, 0), 0);
+}
+
 TEST(ExecutionResult, IdentifiesSetupFailure) {
   BatchResult batch_result;
   batch_result.exit_code() = EXIT_FAILURE;
@@ -0,0 +1,98 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./centipede/shared_coverage_frontier.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "./centipede/binary_info.h"
+#include "./centipede/control_flow.h"
+#include "./centipede/corpus.h"
+#include "./centipede/feature.h"
+
+namespace centipede {
+
+SharedCoverageFrontier::SharedCoverageFrontier(const BinaryInfo &binary_info)
+    : num_pcs_(binary_info.pc_table.size()),
+      frontier_(binary_info),
+      covered_words_((num_pcs_ + 63) / 64),
+      last_selected_(num_pcs_) {}
+
+bool SharedCoverageFrontier::AllCovered(const FeatureVec &fv) const {
+  for (auto feature : fv) {
+    if (!feature_domains::kPCs.Contains(feature)) continue;
+    size_t idx = ConvertPCFeatureToPcIndex(feature);
+    if (idx >= num_pcs_) continue;
+    const uint64_t word =
+        covered_words_[idx / 64].load(std::memory_order_acquire);
+    if ((word & (1ULL << (idx % 64))) == 0) return false;
+  }
+  return true;
+}
+
+void SharedCoverageFrontier::AddCoverage(const FeatureVec &fv) {
+  // Most inputs reaching here add no new PCs, only other new features.
+  if (AllCovered(fv)) return;
+  absl::MutexLock lock(&mu_);
+  frontier_.AddCoverage(fv);
+  const PCIndexVec &changes = frontier_.GlobalFrontierChanges();
+  change_log_.insert(change_log_.end(), changes.begin(), changes.end());
+  frontier_.ClearGlobalFrontierChanges();
+  // Publish the new bits only now that frontier_ has them.
+  for (auto feature : fv) {
+    if (!feature_domains::kPCs.Contains(feature)) continue;
+    size_t idx = ConvertPCFeatureToPcIndex(feature);
+    if (idx >= num_pcs_) continue;
+    covered_words_[idx / 64].fetch_or(1ULL << (idx % 64),
+                                      std::memory_order_release);
+  }
+}
+
+void SharedCoverageFrontier::Read(
+    absl::FunctionRef<void(const CoverageFrontier &frontier)> callback) const {
+  absl::ReaderMutexLock lock(&mu_);
+  callback(frontier_);
+}
+
+void SharedCoverageFrontier::ReadChangesSince(
+    size_t &version,
+    absl::FunctionRef<void(const CoverageFrontier &frontier,
+                           absl::Span<const PCIndex> changed_pcs)>
+        callback) const {
+  absl::ReaderMutexLock lock(&mu_);
+  callback(frontier_, absl::MakeConstSpan(change_log_).subspan(version));
+  version = change_log_.size();
+}
+
+void SharedCoverageFrontier::UpdateFrontierWeights(size_t num_threads) {
+  absl::MutexLock lock(&mu_);
+  frontier_.UpdateFrontierWeights(num_threads);
+}
+
+size_t SharedCoverageFrontier::NumFunctionsInFrontier() const {
+  absl::ReaderMutexLock lock(&mu_);
+  return frontier_.NumFunctionsInFrontier();
+}
+
+size_t SharedCoverageFrontier::NumGlobalFrontierNodes() const {
+  absl::ReaderMutexLock lock(&mu_);
+  return frontier_.NumGlobalFrontierNodes();
+}
+
+}  // namespace centipede
@@ -0,0 +1,138 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_CENTIPEDE_SHARED_COVERAGE_FRONTIER_H_
+#define THIRD_PARTY_CENTIPEDE_SHARED_COVERAGE_FRONTIER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "./centipede/binary_info.h"
+#include "./centipede/control_flow.h"
+#include "./centipede/corpus.h"
+#include "./centipede/feature.h"
+
+namespace centipede {
+
+// The coverage frontier of the whole process, shared by all fuzzing threads,
+// so that the frontier is computed once rather than once per thread, together
+// with the history of frontier PCs selected by the seed schedulers of all the
+// threads, so that the threads spread over different frontiers.
+//
+// Thread-safe.
+class SharedCoverageFrontier {
+ public:
+  // The lifetime of `binary_info` should be longer than for `this`.
+  explicit SharedCoverageFrontier(const BinaryInfo &binary_info);
+
+  SharedCoverageFrontier(const SharedCoverageFrontier &) = delete;
+  SharedCoverageFrontier &operator=(const SharedCoverageFrontier &) = delete;
+
+  // Coverage.
+
+  // Same as CoverageFrontier::AddCoverage(). Takes the lock only if some PCs
+  // in `fv` are not covered yet.
+  void AddCoverage(const FeatureVec &fv);
+
+  // Calls `callback` with the frontier, under a reader lock. The frontier
+  // must not be used after `callback` returns.
+  void Read(
+      absl::FunctionRef<void(const CoverageFrontier &frontier)> callback) const;
+
+  // Same as Read(), but also passes the PCs whose frontier status changed
+  // since `version`, then advances `version`. Every reader keeps its own
+  // `version`, initially 0.
+  void ReadChangesSince(
+      size_t &version,
+      absl::FunctionRef<void(const CoverageFrontier &frontier,
+                             absl::Span<const PCIndex> changed_pcs)>
+          callback) const;
+
+  // Same as CoverageFrontier::UpdateFrontierWeights(). Stale weights are
+  // recomputed once, by whichever thread calls this first.
+  void UpdateFrontierWeights(size_t num_threads);
+
+  // Same as the CoverageFrontier methods.
+  size_t NumFunctionsInFrontier() const;
+  size_t NumGlobalFrontierNodes() const;
+
+  // Selection history.
+
+  // Starts a new selection batch, returns its stamp. Stamps are positive and
+  // increase with every batch of every thread.
+  size_t BeginSelectionBatch() { return ++selection_batch_; }
+
+  // Returns true iff frontier PC `pc_index` was selected by some thread since
+  // the last ResetSelections() and within the last `window` batches before
+  // `stamp` (ever, if `window` is 0).
+  bool SelectedRecently(PCIndex pc_index, size_t stamp, size_t window) const {
+    const size_t last_selected =
+        last_selected_[pc_index].load(std::memory_order_relaxed);
+    if (last_selected == 0 ||
+        last_selected <= selection_floor_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    // Other threads may have selected it in a later batch than `stamp`.
+    return window == 0 || last_selected >= stamp ||
+           stamp - last_selected <= window;
+  }
+
+  // Returns true iff frontier PC `pc_index` was last selected in batch `stamp`.
+  bool SelectedIn(PCIndex pc_index, size_t stamp) const {
+    return last_selected_[pc_index].load(std::memory_order_relaxed) == stamp;
+  }
+
+  // Records that frontier PC `pc_index` was selected in batch `stamp`.
+  void MarkSelected(PCIndex pc_index, size_t stamp) {
+    last_selected_[pc_index].store(stamp, std::memory_order_relaxed);
+  }
+
+  // Forgets the selections made before batch `stamp`.
+  void ResetSelections(size_t stamp) {
+    selection_floor_.store(stamp - 1, std::memory_order_relaxed);
+  }
+
+ private:
+  // Returns true iff all PCs of `fv` are set in covered_words_.
+  bool AllCovered(const FeatureVec &fv) const;
+
+  const size_t num_pcs_;
+
+  mutable absl::Mutex mu_;
+  CoverageFrontier frontier_ ABSL_GUARDED_BY(mu_);
+  // The PCs whose frontier status changed, in the order of the changes. A PC
+  // enters the frontier at most once and leaves it at most once, so the log
+  // is bounded by twice the number of PCs. A reader's version is the log
+  // size it has seen.
+  PCIndexVec change_log_ ABSL_GUARDED_BY(mu_);
+
+  // Covered PC bits, set once frontier_ has them. Read without the lock.
+  std::vector<std::atomic<uint64_t>> covered_words_;
+
+  // last_selected_[pc_index] is the stamp of the batch that last selected
+  // `pc_index`, or 0. Selections at or below selection_floor_ are forgotten.
+  std::vector<std::atomic<size_t>> last_selected_;
+  std::atomic<size_t> selection_batch_ = 0;
+  std::atomic<size_t> selection_floor_ = 0;
+};
+
+}  // namespace centipede
+
+#endif  // THIRD_PARTY_CENTIPEDE_SHARED_COVERAGE_FRONTIER_H_
@@ -0,0 +1,141 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./centipede/shared_coverage_frontier.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/types/span.h"
+#include "./centipede/binary_info.h"
+#include "./centipede/control_flow.h"
+#include "./centipede/corpus.h"
+#include "./centipede/feature.h"
+#include "./centipede/pc_info.h"
+#include "./centipede/test_binary_info_util.h"
+#include "./centipede/thread_pool.h"
+
+namespace centipede {
+namespace {
+
+constexpr size_t kNumFunctions = 64;
+
+// Covers bbs 0 and 1 of function `f`, and all its bbs if `f` % 3 == 0.
+FeatureVec FunctionCoverage(size_t f) {
+  FeatureVec fv;
+  for (size_t bb = 0; bb < 4; ++bb) {
+    if (bb < 2 || f % 3 == 0) {
+      fv.push_back(feature_domains::kPCs.ConvertToMe(4 * f + bb));
+    }
+  }
+  return fv;
+}
+
+TEST(SharedCoverageFrontier, ConcurrentAddCoverageMatchesSequential) {
+  const BinaryInfo bin_info = DiamondFunctions(kNumFunctions);
+  CoverageFrontier sequential(bin_info);
+  for (size_t f = 0; f < kNumFunctions; ++f) {
+    sequential.AddCoverage(FunctionCoverage(f));
+  }
+
+  SharedCoverageFrontier shared(bin_info);
+  constexpr size_t kNumThreads = 4;
+  {
+    ThreadPool threads{kNumThreads};
+    for (size_t t = 0; t < kNumThreads; ++t) {
+      threads.Schedule([&shared, t]() {
+        // Every input twice: the second time takes the lock-free path.
+        for (size_t i = 0; i < 2; ++i) {
+          for (size_t f = t; f < kNumFunctions; f += kNumThreads) {
+            shared.AddCoverage(FunctionCoverage(f));
+          }
+        }
+      });
+    }
+  }  // The threads join here.
+
+  EXPECT_EQ(shared.NumFunctionsInFrontier(),
+            sequential.NumFunctionsInFrontier());
+  EXPECT_EQ(shared.NumGlobalFrontierNodes(),
+            sequential.NumGlobalFrontierNodes());
+  shared.Read([&](const CoverageFrontier &frontier) {
+    for (size_t i = 0; i < bin_info.pc_table.size(); ++i) {
+      EXPECT_EQ(frontier.PcIndexIsGlobalFrontier(i),
+                sequential.PcIndexIsGlobalFrontier(i))
+          << i;
+    }
+  });
+}
+
+TEST(SharedCoverageFrontier, ReadChangesSince) {
+  const BinaryInfo bin_info = DiamondFunctions(kNumFunctions);
+  SharedCoverageFrontier shared(bin_info);
+  size_t version = 0;
+  auto changes_since = [&](size_t &version) {
+    PCIndexVec changes;
+    shared.ReadChangesSince(
+        version,
+        [&](const CoverageFrontier &, absl::Span<const PCIndex> changed_pcs) {
+          changes.assign(changed_pcs.begin(), changed_pcs.end());
+        });
+    return changes;
+  };
+
+  EXPECT_TRUE(changes_since(version).empty());
+  shared.AddCoverage(FunctionCoverage(1));
+  // Bbs 0 and 1 of function 1 enter the frontier.
+  EXPECT_EQ(changes_since(version), PCIndexVec({4, 5}));
+  EXPECT_TRUE(changes_since(version).empty());
+
+  // A reader that has seen nothing yet gets all the changes.
+  size_t other_version = 0;
+  shared.AddCoverage({feature_domains::kPCs.ConvertToMe(6),
+                      feature_domains::kPCs.ConvertToMe(7)});
+  const PCIndexVec all_changes = changes_since(other_version);
+  EXPECT_EQ(all_changes.size(), 2 + changes_since(version).size());
+}
+
+TEST(SharedCoverageFrontier, SelectionHistory) {
+  const BinaryInfo bin_info = DiamondFunctions(kNumFunctions);
+  SharedCoverageFrontier shared(bin_info);
+  constexpr size_t kWindow = 2;
+
+  const size_t first = shared.BeginSelectionBatch();
+  EXPECT_FALSE(shared.SelectedRecently(4, first, kWindow));
+  shared.MarkSelected(4, first);
+  EXPECT_TRUE(shared.SelectedRecently(4, first, kWindow));
+
+  // Another thread's later batch is seen by an earlier one.
+  const size_t second = shared.BeginSelectionBatch();
+  EXPECT_GT(second, first);
+  shared.MarkSelected(5, second);
+  EXPECT_TRUE(shared.SelectedRecently(5, first, kWindow));
+
+  // Selections age out of the window, but not with window 0.
+  size_t stamp = second;
+  for (size_t i = 0; i < kWindow; ++i) stamp = shared.BeginSelectionBatch();
+  EXPECT_FALSE(shared.SelectedRecently(4, stamp, kWindow));
+  EXPECT_TRUE(shared.SelectedRecently(5, stamp, kWindow));
+  EXPECT_TRUE(shared.SelectedRecently(4, stamp, /*window=*/0));
+
+  // A reset forgets all earlier selections.
+  shared.ResetSelections(stamp);
+  EXPECT_FALSE(shared.SelectedRecently(5, stamp, /*window=*/0));
+  shared.MarkSelected(5, stamp);
+  EXPECT_TRUE(shared.SelectedRecently(5, stamp, /*window=*/0));
+}
+
+}  // namespace
+}  // namespace centipede
@@ -0,0 +1,64 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./centipede/test_binary_info_util.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "./centipede/binary_info.h"
+#include "./centipede/call_graph.h"
+#include "./centipede/control_flow.h"
+#include "./centipede/pc_info.h"
+
+namespace centipede {
+
+BinaryInfo DiamondFunctions(size_t num_functions, DiamondCalls calls) {
+  auto pc = [](size_t f, size_t bb) -> intptr_t { return 1 + 4 * f + bb; };
+  PCTable pc_table;
+  CFTable cf_table;
+  for (size_t f = 0; f < num_functions; ++f) {
+    const intptr_t next = pc((f + 1) % num_functions, 0);
+    const intptr_t random = pc((f * 7 + 3) % num_functions, 0);
+    for (size_t bb = 0; bb < 4; ++bb) {
+      pc_table.push_back({static_cast<uintptr_t>(pc(f, bb)),
+                          bb == 0 ? PCInfo::kFuncEntry : 0});
+    }
+    cf_table.insert(cf_table.end(), {pc(f, 0), pc(f, 1), pc(f, 2), 0, 0});
+    switch (calls) {
+      case DiamondCalls::kNone:
+        cf_table.insert(cf_table.end(), {pc(f, 1), pc(f, 3), 0, 0});
+        cf_table.insert(cf_table.end(), {pc(f, 2), pc(f, 3), 0, 0});
+        cf_table.insert(cf_table.end(), {pc(f, 3), 0, 0});
+        break;
+      case DiamondCalls::kNext:
+        cf_table.insert(cf_table.end(), {pc(f, 1), pc(f, 3), 0, next, 0});
+        cf_table.insert(cf_table.end(), {pc(f, 2), pc(f, 3), 0, 0});
+        cf_table.insert(cf_table.end(), {pc(f, 3), 0, 0});
+        break;
+      case DiamondCalls::kNextRandomAndIndirect:
+        cf_table.insert(cf_table.end(), {pc(f, 1), pc(f, 3), 0, next, 0});
+        cf_table.insert(cf_table.end(), {pc(f, 2), pc(f, 3), 0, random, 0});
+        cf_table.insert(cf_table.end(), {pc(f, 3), 0, -1, 0});
+        break;
+    }
+  }
+  BinaryInfo bin_info = {pc_table,           {},         cf_table, {},
+                         ControlFlowGraph(), CallGraph()};
+  bin_info.control_flow_graph.InitializeControlFlowGraph(cf_table, pc_table);
+  bin_info.call_graph.InitializeCallGraph(cf_table, pc_table);
+  return bin_info;
+}
+
+}  // namespace centipede
@@ -0,0 +1,43 @@
+// Copyright 2025 The Centipede Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FUZZTEST_CENTIPEDE_TEST_BINARY_INFO_UTIL_H_
+#define FUZZTEST_CENTIPEDE_TEST_BINARY_INFO_UTIL_H_
+
+#include <cstddef>
+
+#include "./centipede/binary_info.h"
+
+namespace centipede {
+
+// The calls made by the functions of `DiamondFunctions()`.
+enum class DiamondCalls {
+  // No calls.
+  kNone,
+  // Bb 1 calls the next function, the last one calls the first one.
+  kNext,
+  // As `kNext`, and also bb 2 calls a pseudo-random function and bb 3 makes an
+  // indirect call.
+  kNextRandomAndIndirect,
+};
+
+// Returns the binary info of `num_functions` diamond functions: in function
+// `f`, bb 0 branches to bbs 1 and 2 that join in bb 3. Bb `bb` of function
+// `f` has the PC index 4 * f + bb and the PC 1 + 4 * f + bb.
+BinaryInfo DiamondFunctions(size_t num_functions,
+                            DiamondCalls calls = DiamondCalls::kNext);
+
+}  // namespace centipede
+
+#endif  // FUZZTEST_CENTIPEDE_TEST_BINARY_INFO_UTIL_H_
@@ -32,6 +32,7 @@
 #include <fstream>
 #include <functional>
 #include <ios>
+#include <optional>
 #include <queue>
 #include <random>
 #include <sstream>
@@ -222,11 +223,10 @@ ByteArray PackFeaturesAndHash(const ByteArray &data,
 ByteArray PackFeaturesAndHashAsRawBytes(const ByteArray &data,
                                         ByteSpan features) {
   ByteArray feature_bytes_with_hash(features.size() + kHashLen);
-  auto hash = Hash(data);
-  CHECK_EQ(hash.size(), kHashLen);
   memcpy(feature_bytes_with_hash.data(), features.data(), features.size());
-  memcpy(feature_bytes_with_hash.data() + features.size(), hash.data(),
-         kHashLen);
+  HashDigestToHex(HashDigestOf(data),
+                  reinterpret_cast<char *>(feature_bytes_with_hash.data() +
+                                           features.size()));
   return feature_bytes_with_hash;
 }
 
@@ -241,6 +241,19 @@ std::string UnpackFeaturesAndHash(ByteSpan blob,
   return hash;
 }
 
+std::optional<HashDigest> UnpackFeaturesAndHashDigest(
+    ByteSpan blob, absl::Nonnull<FeatureVec *> features) {
+  if (blob.size() < kHashLen) return std::nullopt;
+  const ByteSpan hash = blob.subspan(blob.size() - kHashLen);
+  std::optional<HashDigest> digest = HashDigestFromHex(
+      {reinterpret_cast<const char *>(hash.data()), hash.size()});
+  if (!digest.has_value()) return std::nullopt;
+  const size_t features_len_in_bytes = blob.size() - kHashLen;
+  features->resize(features_len_in_bytes / sizeof(feature_t));
+  memcpy(features->data(), blob.data(), features_len_in_bytes);
+  return digest;
+}
+
 // Returns a vector of string pairs that are used to replace special characters
 // and hex values in ParseAFLDictionary.
 static std::vector<std::pair<std::string, std::string>>
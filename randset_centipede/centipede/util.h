@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -27,6 +28,7 @@
 #include "absl/types/span.h"
 #include "./centipede/feature.h"
 #include "./common/defs.h"
+#include "./common/hash.h"
 
 namespace centipede {
 
@@ -148,6 +150,10 @@ ByteArray PackFeaturesAndHashAsRawBytes(const ByteArray &data,
 // `features` and return the hash.
 std::string UnpackFeaturesAndHash(ByteSpan blob,
                                   absl::Nonnull<FeatureVec *> features);
+// Same as above, but returns the binary digest of the hash, or std::nullopt
+// (with `features` untouched) if the hash in `blob` is not a valid one.
+std::optional<HashDigest> UnpackFeaturesAndHashDigest(
+    ByteSpan blob, absl::Nonnull<FeatureVec *> features);
 
 // Parses `dictionary_text` representing an AFL/libFuzzer dictionary.
 // https://github.com/google/AFL/blob/master/dictionaries/README.dictionaries
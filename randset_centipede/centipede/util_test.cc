@@ -18,6 +18,7 @@
 #include <cstdlib>
 #include <filesystem>  // NOLINT
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -101,6 +102,26 @@ TEST(UtilTest, PackAndUnpackFeaturesAsRawBytes) {
   EXPECT_EQ(hash, unpacked_hash);
 }
 
+TEST(UtilTest, UnpackFeaturesAndHashDigest) {
+  const ByteArray kData{1, 2, 3, 4};
+  const FeatureVec kFeatures = {102, 30, 7, 15};
+  ByteArray packed = PackFeaturesAndHash(kData, kFeatures);
+
+  FeatureVec unpacked_features;
+  EXPECT_EQ(UnpackFeaturesAndHashDigest(packed, &unpacked_features),
+            HashDigestOf(kData));
+  EXPECT_EQ(kFeatures, unpacked_features);
+
+  // Not a valid hash: the features are left alone.
+  packed.back() = 'x';
+  unpacked_features.clear();
+  EXPECT_EQ(UnpackFeaturesAndHashDigest(packed, &unpacked_features),
+            std::nullopt);
+  EXPECT_TRUE(unpacked_features.empty());
+  EXPECT_EQ(UnpackFeaturesAndHashDigest({1, 2, 3}, &unpacked_features),
+            std::nullopt);
+}
+
 // Tests TemporaryLocalDirPath from several threads.
 TEST(UtilTest, TemporaryLocalDirPath) {
   {
@@ -168,6 +168,22 @@ WorkDir::PathShards WorkDir::DistilledFeaturesFilePaths() const {
           my_shard_index_};
 }
 
+WorkDir::PathShards WorkDir::DistilledCoverCorpusFilePaths(
+    size_t cover_index) const {
+  return {workdir_,
+          absl::StrCat(kDistilledCorpusShardStemPrefix, binary_name_, "-cover",
+                       cover_index, "."),
+          my_shard_index_};
+}
+
+WorkDir::PathShards WorkDir::DistilledCoverFeaturesFilePaths(
+    size_t cover_index) const {
+  return {CoverageDirPath(),
+          absl::StrCat("distilled-features-", binary_name_, "-cover",
+                       cover_index, "."),
+          my_shard_index_};
+}
+
 std::string WorkDir::CoverageReportPath(std::string_view annotation) const {
   return std::filesystem::path(workdir_) /
          absl::StrFormat("coverage-report-%s.%0*d%s.txt", binary_name_,
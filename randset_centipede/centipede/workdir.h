@@ -120,6 +120,12 @@ class WorkDir {
   PathShards FeaturesFilePaths() const;
   // Returns the paths for the sharded distilled features file.
   PathShards DistilledFeaturesFilePaths() const;
+  // Returns the paths for the sharded distilled corpus file of frontier cover
+  // `cover_index` (see `--distill_frontier_covers`).
+  PathShards DistilledCoverCorpusFilePaths(size_t cover_index) const;
+  // Returns the paths for the sharded distilled features file of frontier
+  // cover `cover_index`.
+  PathShards DistilledCoverFeaturesFilePaths(size_t cover_index) const;
 
   // Returns the path for the coverage report file for my_shard_index.
   // Non-default `annotation` becomes a part of the returned filename.
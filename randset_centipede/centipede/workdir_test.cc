@@ -101,6 +101,15 @@ TEST(WorkDirTest, Api) {
   EXPECT_TRUE(wd.DistilledFeaturesFilePaths().IsShard(  //
       "/dir/bin-hash/distilled-features-bin.000009"));
 
+  EXPECT_EQ(wd.DistilledCoverCorpusFilePaths(2).MyShard(),  //
+            "/dir/distilled-bin-cover2.000003");
+  EXPECT_EQ(wd.DistilledCoverCorpusFilePaths(2).AllShardsGlob(),  //
+            "/dir/distilled-bin-cover2.*");
+  EXPECT_FALSE(wd.DistilledCorpusFilePaths().IsShard(  //
+      "/dir/distilled-bin-cover2.000003"));
+  EXPECT_EQ(wd.DistilledCoverFeaturesFilePaths(2).MyShard(),  //
+            "/dir/bin-hash/distilled-features-bin-cover2.000003");
+
   EXPECT_EQ(wd.CoverageReportPath(),  //
             "/dir/coverage-report-bin.000003.txt");
   EXPECT_EQ(wd.CoverageReportPath("anno"),
@@ -16,6 +16,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -24,25 +25,51 @@
 
 namespace centipede {
 
-std::string Hash(ByteSpan span) {
-  // Compute SHA1.
-  uint8_t sha1[kShaDigestLength];
-  SHA1(span.data(), span.size(), sha1);
-  // Convert SHA1 to text.
-  static_assert(kHashLen == 2 * kShaDigestLength);
-  char sha1_hex_text[kHashLen];
+std::string Hash(ByteSpan span) { return HashDigestToHex(HashDigestOf(span)); }
+
+std::string Hash(std::string_view str) {
+  static_assert(sizeof(decltype(str)::value_type) == sizeof(uint8_t));
+  return Hash(AsByteSpan(str));
+}
+
+HashDigest HashDigestOf(ByteSpan span) {
+  static_assert(sizeof(HashDigest) == kShaDigestLength);
+  HashDigest digest;
+  SHA1(span.data(), span.size(), digest.data());
+  return digest;
+}
+
+void HashDigestToHex(const HashDigest &digest, char *out) {
   static const char hex[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
                                '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-  for (size_t i = 0; i < kShaDigestLength; i++) {
-    sha1_hex_text[i * 2 + 0] = hex[sha1[i] / 16];
-    sha1_hex_text[i * 2 + 1] = hex[sha1[i] % 16];
+  for (size_t i = 0; i < digest.size(); i++) {
+    out[i * 2 + 0] = hex[digest[i] / 16];
+    out[i * 2 + 1] = hex[digest[i] % 16];
   }
-  return {sha1_hex_text, sha1_hex_text + kHashLen};
 }
 
-std::string Hash(std::string_view str) {
-  static_assert(sizeof(decltype(str)::value_type) == sizeof(uint8_t));
-  return Hash(AsByteSpan(str));
+std::string HashDigestToHex(const HashDigest &digest) {
+  std::string hex(kHashLen, '\0');
+  HashDigestToHex(digest, hex.data());
+  return hex;
+}
+
+std::optional<HashDigest> HashDigestFromHex(std::string_view hex) {
+  if (hex.size() != kHashLen) return std::nullopt;
+  auto nibble = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  };
+  HashDigest digest;
+  for (size_t i = 0; i < digest.size(); i++) {
+    const int high = nibble(hex[i * 2]);
+    const int low = nibble(hex[i * 2 + 1]);
+    if (high < 0 || low < 0) return std::nullopt;
+    digest[i] = static_cast<uint8_t>(high * 16 + low);
+  }
+  return digest;
 }
 
 }  // namespace centipede
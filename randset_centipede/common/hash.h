@@ -15,7 +15,10 @@
 #ifndef FUZZTEST_COMMON_UTIL_H_
 #define FUZZTEST_COMMON_UTIL_H_
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -30,6 +33,21 @@ std::string Hash(std::string_view str);
 // Hashes are always this many bytes.
 inline constexpr size_t kHashLen = 40;
 
+// The binary digest behind Hash(): Hash() is its lowercase hex. Cheaper to
+// compute, store and compare than Hash(), for keying inputs in memory; the
+// hex form remains the one used in file names and files.
+using HashDigest = std::array<uint8_t, kHashLen / 2>;
+
+// Returns the digest of a byte array.
+HashDigest HashDigestOf(ByteSpan span);
+// Writes the kHashLen hex characters of `digest` to `out`.
+void HashDigestToHex(const HashDigest &digest, char *out);
+// Returns the hex of `digest`, i.e. the Hash() it is the digest of.
+std::string HashDigestToHex(const HashDigest &digest);
+// Returns the digest whose hex is `hex`, or std::nullopt if `hex` is not
+// kHashLen hex characters.
+std::optional<HashDigest> HashDigestFromHex(std::string_view hex);
+
 }  // namespace centipede
 
 #endif  // FUZZTEST_COMMON_UTIL_H_
@@ -14,6 +14,8 @@
 
 #include "./common/hash.h"
 
+#include <optional>
+
 #include "gtest/gtest.h"
 
 namespace centipede {
@@ -27,5 +29,18 @@ TEST(UtilTest, Hash) {
   EXPECT_EQ(Hash({'x', 'y'}), "5f8459982f9f619f4b0d9af2542a2086e56a4bef");
 }
 
+TEST(UtilTest, HashDigest) {
+  const HashDigest digest = HashDigestOf({'a', 'b', 'c'});
+  EXPECT_EQ(digest[0], 0xa9);
+  EXPECT_EQ(digest[19], 0x9d);
+  EXPECT_EQ(HashDigestToHex(digest), Hash({'a', 'b', 'c'}));
+  EXPECT_EQ(HashDigestFromHex(Hash({'a', 'b', 'c'})), digest);
+  EXPECT_EQ(HashDigestFromHex("A9993E364706816ABA3E25717850C26C9CD0D89D"),
+            digest);
+  EXPECT_EQ(HashDigestFromHex("a9993e"), std::nullopt);
+  EXPECT_EQ(HashDigestFromHex("g9993e364706816aba3e25717850c26c9cd0d89d"),
+            std::nullopt);
+}
+
 }  // namespace
 }  // namespace centipede